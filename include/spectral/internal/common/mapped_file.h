@@ -0,0 +1,58 @@
+#ifndef INCLUDE_SPECTRAL_INTERNAL_COMMON_MAPPED_FILE_H
+#define INCLUDE_SPECTRAL_INTERNAL_COMMON_MAPPED_FILE_H
+#include <cstddef>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace spec {
+
+    /**
+     *  Read-only contents of whole file. File is memory mapped where supported (pages are shared
+     * with other processes mapping the same file), otherwise it is read to memory.
+     */
+    class MappedFile
+    {
+    public:
+        using ptr = std::shared_ptr<const MappedFile>;
+
+        /**
+         *  Throws std::runtime_error if file can't be opened.
+         */
+        explicit MappedFile(const std::string &path);
+
+        MappedFile(const MappedFile &) = delete;
+        MappedFile &operator=(const MappedFile &) = delete;
+
+        ~MappedFile();
+
+        const char *data() const
+        {
+            return begin;
+        }
+
+        size_t size() const
+        {
+            return length;
+        }
+
+        bool is_mapped() const
+        {
+            return mapped;
+        }
+
+        static ptr open(const std::string &path)
+        {
+            return std::make_shared<const MappedFile>(path);
+        }
+
+    private:
+        const char *begin;
+        size_t length;
+        bool mapped;
+        std::vector<char> buffer;
+    };
+
+}
+
+#endif
@@ -0,0 +1,104 @@
+#ifndef INCLUDE_SPECTRAL_INTERNAL_COMMON_PROGRESS_H
+#define INCLUDE_SPECTRAL_INTERNAL_COMMON_PROGRESS_H
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <functional>
+#include <mutex>
+
+namespace spec {
+
+    /**
+     *  Progress of long operation. add() may be called from any number of threads.
+     * Reports are throttled (by count and by time) and passed to callback under lock,
+     * so callback is never called concurrently.
+     *
+     *  If no callback is set, progress is silent and add() returns immediately.
+     */
+    class Progress
+    {
+    public:
+        struct Info
+        {
+            size_t done;
+            size_t total;
+            double elapsed; //seconds
+            double rate;    //items per second
+            double eta;     //seconds
+            bool finished;
+        };
+
+        using Callback = std::function<void(const Info &)>;
+        using Clock = std::chrono::steady_clock;
+
+        static constexpr std::chrono::milliseconds DEFAULT_INTERVAL{100};
+
+        /**
+         *  Uses default callback (see set_default_callback).
+         */
+        explicit Progress(size_t total);
+
+        Progress(size_t total, Callback callback, std::chrono::milliseconds interval = DEFAULT_INTERVAL);
+
+        Progress(const Progress &) = delete;
+        Progress &operator=(const Progress &) = delete;
+
+        inline void add(size_t count = 1)
+        {
+            if(!callback) return;
+            const size_t val = done.fetch_add(count, std::memory_order_relaxed) + count;
+            if(val >= next_report.load(std::memory_order_relaxed)) {
+                report(val, false);
+            }
+        }
+
+        /**
+         *  Reports final state. Does nothing if called twice.
+         */
+        void finish();
+
+        size_t get_done() const
+        {
+            return done.load(std::memory_order_relaxed);
+        }
+
+        size_t get_total() const
+        {
+            return total;
+        }
+
+        bool is_silent() const
+        {
+            return !callback;
+        }
+
+        /**
+         *  Callback used by progress objects created inside the library. Empty callback disables reporting.
+         * Not thread-safe, should be set before any work starts.
+         */
+        static void set_default_callback(Callback callback);
+        static const Callback &get_default_callback();
+
+        /**
+         *  Draws progress bar in stdout.
+         */
+        static void console_callback(const Info &info);
+
+    private:
+        const size_t total;
+        const Callback callback;
+        const Clock::duration interval;
+        const Clock::time_point start;
+        const size_t count_step;
+        std::atomic<size_t> done;
+        std::atomic<size_t> next_report;
+        Clock::time_point last_report;
+        bool finished;
+        std::mutex report_lock;
+
+        void report(size_t val, bool force);
+    };
+
+}
+
+#endif
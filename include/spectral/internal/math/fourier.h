@@ -28,6 +28,13 @@ namespace spec {
         std::vector<Complex> precompute_mese_coeffs(const std::vector<Complex> &gamma);
         std::vector<Float> precompute_mese_coeffs(const std::vector<Float> &gamma);
 
+        /**
+         *  Computes q-vectors of count real moment vectors of size M + 1 stored one after another in gamma.
+         * Vectors with gamma[0] == 0 get zero q-vector. Independent systems are solved together
+         * in SIMD lanes if CPU supports AVX2.
+         */
+        void precompute_mese_coeffs(const Float *gamma, size_t count, int M, Float *dst);
+
         std::vector<Complex> lagrange_multipliers(const std::vector<Float> &moments);
 
         Float bounded_mese_l(Float phase, const std::vector<Complex> &lagrange_m);
@@ -39,14 +46,72 @@ namespace spec {
 
         Float mese_precomp(Float phase, const std::vector<Float> &moments);
 
-        inline std::vector<Float> mese(std::vector<Float> phases, const std::vector<Float> &moments)
+        /**
+         *  Same as above for q-vector of M + 1 values stored in flat buffer.
+         */
+        Float mese_precomp(Float phase, const Float *q, int M);
+
+        /**
+         *  Fixed grid of phases with cos(k * phase) and sin(k * phase) precomputed up to order max_m,
+         * so MESE of any q-vector up to this order is evaluated without complex exponentials.
+         * Orders above max_m fall back to mese_precomp.
+         */
+        class PhaseGrid
+        {
+        public:
+            PhaseGrid(const std::vector<Float> &phases, int max_m);
+
+            size_t size() const
+            {
+                return phases.size();
+            }
+
+            int get_max_m() const
+            {
+                return max_m;
+            }
+
+            const std::vector<Float> &get_phases() const
+            {
+                return phases;
+            }
+
+            /**
+             *  Writes MESE of q-vector with M + 1 values at all phases of grid to dst.
+             */
+            void mese(const Float *q, int M, Float *dst) const;
+
+            /**
+             *  Writes bounded MESE of M + 1 lagrange multipliers at all phases of grid to dst.
+             */
+            void bounded_mese_l(const Complex *lagrange_m, int M, Float *dst) const;
+
+        private:
+            std::vector<Float> phases;
+            int max_m;
+            std::vector<Float> cos_table; //[k * size() + j]
+            std::vector<Float> sin_table;
+        };
+
+        /**
+         *  Phases of wavelenghts WAVELENGHTS_START, WAVELENGHTS_START + WAVELENGHTS_STEP, ..., WAVELENGHTS_END.
+         */
+        const PhaseGrid &cie_phase_grid();
+
+        inline std::vector<Float> mese(const std::vector<Float> &phases, const std::vector<Float> &moments)
         {
-            std::vector<Float> q = precompute_mese_coeffs(moments);
+            const std::vector<Float> q = precompute_mese_coeffs(moments);
+            const int M = q.size() - 1;
 
-            for(unsigned k = 0; k < phases.size(); ++k) {
-                phases[k] = mese_precomp(phases[k], q);
+            std::vector<Float> res(phases.size());
+            const PhaseGrid &cie = cie_phase_grid();
+            if(M <= cie.get_max_m() && phases == cie.get_phases()) {
+                cie.mese(q.data(), M, res.data());
+            }
+            else {
+                PhaseGrid{phases, M}.mese(q.data(), M, res.data());
             }
-            return phases;
+            return res;
         }
 
         inline Float mese(Float phase, const std::vector<Float> &moments)
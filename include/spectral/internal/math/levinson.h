@@ -1,56 +1,105 @@
 #ifndef INCLUDE_SPECTAL_INTERNAL_MATH_LEVINSON_H
 #define INCLUDE_SPECTAL_INTERNAL_MATH_LEVINSON_H
+#include <array>
 #include <vector>
 #include <cassert>
 namespace spec::math {
 
+    /**
+     *  Levinson recursion for Toeplitz system of order M working in place.
+     * data holds 2 * M + 1 diagonals (main one at data[M]), y holds M + 1 values.
+     * Solution is written to x, fn and bn are scratch of M + 1 values each.
+     */
     template<typename T, typename P>
-    std::vector<T> levinson(const std::vector<T> &data, const std::vector<P> &y)
+    inline void levinson_inplace(const T *data, const P *y, int M, T *x, T *fn, T *bn)
     {
-        const int N = (data.size() - 1) / 2;
+        const T *diag = data + M;
 
-        auto t = T(1.0) / data[N];
-        std::vector<T> fn{t};
-        std::vector<T> bn{t};
-        std::vector<T> xn(N + 1);
-        xn[0] = y[0] * t;
+        auto t = T(1.0) / diag[0];
+        fn[0] = t;
+        bn[0] = t;
+        x[0] = y[0] * t;
 
-        for(int i = 1; i <= N; ++i) {
+        for(int i = 1; i <= M; ++i) {
             T ef1{0.0};
             T eb1{0.0};
             T ex1{0.0};
 
-            for(int j = 0; j < i; ++j) { //check bounds
-                ef1 += data[N + i - j] * fn[j];
-                ex1 += data[N + i - j] * xn[j];
-                eb1 += data[N - j - 1] * bn[j];
+            for(int j = 0; j < i; ++j) {
+                ef1 += diag[i - j] * fn[j];
+                ex1 += diag[i - j] * x[j];
+                eb1 += diag[-j - 1] * bn[j];
             }
-            std::vector<T> fn1(i + 1, T(0.0));
-            std::vector<T> bn1(i + 1, T(0.0));
 
+            //new fn[j] and bn[j] depend on fn[j] and bn[j - 1] only, so update goes backwards
             T div = T(1.0) / (T(1.0) - ef1 * eb1);
-            for(int j = 0; j < i; ++j) {
-                fn1[j] = div * fn[j];
-                bn1[j] = -eb1 * div * fn[j];
-            }
-            for(int j = 1; j <= i; ++j) {
-                fn1[j] -= ef1 * div * bn[j - 1];
-                bn1[j] += div * bn[j - 1];
+            fn[i] = T(0.0) - ef1 * div * bn[i - 1];
+            bn[i] = T(0.0) + div * bn[i - 1];
+            for(int j = i - 1; j > 0; --j) {
+                const T f = fn[j];
+                fn[j] = div * f - ef1 * div * bn[j - 1];
+                bn[j] = -eb1 * div * f + div * bn[j - 1];
             }
+            bn[0] = -eb1 * div * fn[0];
+            fn[0] = div * fn[0];
 
             T mul = y[i] - ex1;
             for(int j = 0; j < i; ++j) {
-                xn[j] += mul * bn1[j];
+                x[j] += mul * bn[j];
             }
-            xn[i] = mul * bn1[i];
+            x[i] = mul * bn[i];
+        }
+    }
+
+    /**
+     *  Levinson recursion with order known at compile time, scratch is kept on stack.
+     */
+    template<int M, typename T, typename P>
+    inline void levinson_fixed(const T *data, const P *y, T *x)
+    {
+        std::array<T, M + 1> fn;
+        std::array<T, M + 1> bn;
+        levinson_inplace(data, y, M, x, fn.data(), bn.data());
+    }
 
-            fn = std::move(fn1);
-            bn = std::move(bn1);
+    /**
+     *  Solves Toeplitz system of order M, common orders use fixed size scratch.
+     */
+    template<typename T, typename P>
+    void levinson(const T *data, const P *y, int M, T *x)
+    {
+        switch(M) {
+        case 4:
+            levinson_fixed<4>(data, y, x);
+            break;
+        case 8:
+            levinson_fixed<8>(data, y, x);
+            break;
+        case 12:
+            levinson_fixed<12>(data, y, x);
+            break;
+        case 16:
+            levinson_fixed<16>(data, y, x);
+            break;
+        default: {
+            std::vector<T> scratch(2 * (M + 1));
+            levinson_inplace(data, y, M, x, scratch.data(), scratch.data() + M + 1);
+        }
         }
+    }
+
+    template<typename T, typename P>
+    std::vector<T> levinson(const std::vector<T> &data, const std::vector<P> &y)
+    {
+        assert(data.size() % 2 == 1 && y.size() == (data.size() + 1) / 2);
+        const int N = (data.size() - 1) / 2;
+
+        std::vector<T> xn(N + 1);
+        levinson(data.data(), y.data(), N, xn.data());
         return xn;
     }
 
 }
 
 
-#endif
\ No newline at end of file
+#endif
@@ -4,6 +4,9 @@
 #include <spectral/internal/common/util.h>
 #include <ostream>
 #include <istream>
+#include <algorithm>
+#include <cstddef>
+#include <vector>
 
 namespace spec::binary {
 
@@ -61,11 +64,56 @@ namespace spec::binary {
         return v;
     }
 
+    /**
+     *  Bulk variants, values are read with single stream call and byte order is fixed in one pass afterwards.
+     * Without order specified, data are stored as big-endian (same as read/write).
+     */
+    template<typename T, typename = std::enable_if_t<std::is_arithmetic_v<T>, void>>
+    void read_array_ordered(std::istream &src, T *dst, size_t count, bool from_big_endian)
+    {
+        src.read(reinterpret_cast<char *>(dst), count * sizeof(T));
+        if(is_little_endian() == from_big_endian) {
+            spec::swap_bytes(reinterpret_cast<char *>(dst), count, sizeof(T));
+        }
+    }
+
+    template<typename T, typename = std::enable_if_t<std::is_arithmetic_v<T>, void>>
+    void write_array_ordered(std::ostream &dst, const T *src, size_t count, bool to_big_endian)
+    {
+        if(is_little_endian() != to_big_endian) {
+            dst.write(reinterpret_cast<const char *>(src), count * sizeof(T));
+            return;
+        }
+
+        constexpr size_t CHUNK = 16384;
+        std::vector<T> buf(std::min(CHUNK, count));
+        for(size_t i = 0; i < count; i += CHUNK) {
+            const size_t n = std::min(CHUNK, count - i);
+            std::copy(src + i, src + i + n, buf.data());
+            spec::swap_bytes(reinterpret_cast<char *>(buf.data()), n, sizeof(T));
+            dst.write(reinterpret_cast<const char *>(buf.data()), n * sizeof(T));
+        }
+    }
+
+    template<typename T, typename = std::enable_if_t<std::is_arithmetic_v<T>, void>>
+    void read_array(std::istream &src, T *dst, size_t count)
+    {
+        read_array_ordered<T>(src, dst, count, true);
+    }
+
+    template<typename T, typename = std::enable_if_t<std::is_arithmetic_v<T>, void>>
+    void write_array(std::ostream &dst, const T *src, size_t count)
+    {
+        write_array_ordered<T>(dst, src, count, true);
+    }
+
 
     extern template void write(std::ostream &dst, Float val);
     extern template Float read(std::istream &src);
     extern template void write_vec(std::ostream &dst, const vec3 &val);
     extern template vec3 read_vec(std::istream &src);
+    extern template void read_array(std::istream &src, Float *dst, size_t count);
+    extern template void write_array(std::ostream &dst, const Float *src, size_t count);
 
 }
 
@@ -28,11 +28,17 @@ namespace spec {
         Interleave interleave;
 
         std::vector<Float> wavelength;
-        std::vector<unsigned> illuminant;
+        std::vector<Float> illuminant;
+        std::vector<Float> illuminant_wavelength; // empty if illuminant is sampled at band wavelengths
 
         std::unordered_map<std::string, std::string> additional;
 
         static MetaENVI load(const std::string &path);
+
+        /**
+         *  Writes header readable by load. Unsupported data types and units and additional entries are not written.
+         */
+        void save(const std::string &path) const;
     };
 
 }
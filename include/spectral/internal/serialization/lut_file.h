@@ -0,0 +1,91 @@
+#ifndef INCLUDE_SPECTRAL_INTERNAL_SERIALIZATION_LUT_FILE_H
+#define INCLUDE_SPECTRAL_INTERNAL_SERIALIZATION_LUT_FILE_H
+#include <spectral/internal/math/math_fwd.h>
+#include <cinttypes>
+#include <cstddef>
+#include <istream>
+#include <ostream>
+#include <vector>
+
+/**
+ *  LUT file format v2. All values are little-endian.
+ *
+ *  Header (64 bytes) is followed by power values (Float) and payload starting at 64 byte aligned offset,
+ * so payload can be used directly from memory mapped file. Checksum covers power values and payload.
+ * Verifying it reads whole file, so by default it is done only in debug builds (SPECTRAL_VERIFY_LUT_CHECKSUM).
+ *
+ *  Marker is the same as in v1, but v1 stores it as big-endian, so both versions can be told apart by first 8 bytes.
+ */
+namespace spec::lut_file {
+
+    constexpr uint16_t VERSION = 2;
+    constexpr size_t ALIGNMENT = 64;
+
+    struct Header
+    {
+        uint64_t marker;
+        uint16_t version;
+        uint16_t float_size;
+        uint16_t step;
+        uint16_t m;
+        uint32_t power_count;
+        uint32_t reserved;
+        uint64_t payload_offset;
+        uint64_t payload_size;
+        uint64_t checksum;
+        uint8_t padding[16];
+    };
+
+    static_assert(sizeof(Header) == ALIGNMENT, "LUT header has to be 64 bytes long");
+
+    /**
+     *  Parsed v2 file. Pointers point to the memory given to parse.
+     */
+    struct View
+    {
+        Header header;
+        const Float *power_values;
+        const char *payload;
+    };
+
+    uint64_t checksum(const char *data, size_t size, uint64_t seed);
+    uint64_t checksum(const Float *power_values, size_t power_count, const char *payload, size_t size);
+
+    /**
+     *  Enables or disables checksum verification in parse and read_payload for whole process.
+     */
+    void set_checksum_verification(bool enabled);
+    bool checksum_verification();
+
+    /**
+     *  Throws std::invalid_argument if checksum of view doesn't match its header.
+     */
+    void verify(const View &view);
+
+    bool is_v2(const char *data, size_t size, uint64_t marker);
+    bool is_v2(std::istream &src, uint64_t marker);
+
+    /**
+     *  Memory layout of v2 files is native only on little-endian hosts, other hosts get std::runtime_error.
+     *
+     *  Validates header and that power values and payload fit into size, checksum is verified only if enabled.
+     * Throws std::invalid_argument if file is damaged or unsupported.
+     */
+    View parse(const char *data, size_t size, uint64_t marker);
+
+    /**
+     *  Reads header and power values, stream is left at the start of payload.
+     * Throws std::invalid_argument if file is damaged or unsupported.
+     */
+    Header read_header(std::istream &src, uint64_t marker, std::vector<Float> &power_values);
+
+    /**
+     *  Reads header.payload_size bytes to dst and verifies checksum if enabled. Throws std::invalid_argument on mismatch.
+     */
+    void read_payload(std::istream &src, const Header &header, const std::vector<Float> &power_values, char *dst);
+
+    void write(std::ostream &dst, uint64_t marker, unsigned step, unsigned m, const std::vector<Float> &power_values, const char *payload, size_t size);
+
+}
+
+#endif
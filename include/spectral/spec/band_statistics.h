@@ -0,0 +1,62 @@
+#ifndef INCLUDE_SPECTRAL_SPEC_BAND_STATISTICS_H
+#define INCLUDE_SPECTRAL_SPEC_BAND_STATISTICS_H
+#include <spectral/internal/math/math.h>
+#include <cmath>
+#include <memory>
+#include <vector>
+
+namespace spec {
+
+    /**
+     *  Per-band statistics of spectral image computed in one sweep over all pixels.
+     * Bands are sorted by wavelenght, wavelenghts are union of wavelenghts of all pixels.
+     * NaN values are skipped by all accumulators, including count.
+     */
+    struct BandStatistics
+    {
+        using ptr = std::shared_ptr<const BandStatistics>;
+
+        std::vector<Float> wavelenghts;
+        std::vector<Float> min;
+        std::vector<Float> max;
+        std::vector<Float> mean;
+        std::vector<double> sum;
+        std::vector<long> count; //number of pixels with value other than NaN in band
+
+        BandStatistics() = default;
+
+        explicit BandStatistics(std::vector<Float> wavelenghts);
+
+        int get_bands() const
+        {
+            return wavelenghts.size();
+        }
+
+        /**
+         *  Returns index of band with specified wavelenght or -1 if there is no such band.
+         */
+        int find_band(Float w) const;
+
+        inline void add(int band, Float val)
+        {
+            if(std::isnan(val)) return;
+            min[band] = val < min[band] ? val : min[band];
+            max[band] = val > max[band] ? val : max[band];
+            sum[band] += val;
+            ++count[band];
+        }
+
+        /**
+         *  Adds partial statistics with the same bands.
+         */
+        void merge(const BandStatistics &other);
+
+        /**
+         *  Computes means, should be called after all values are added.
+         */
+        void finish();
+    };
+
+}
+
+#endif
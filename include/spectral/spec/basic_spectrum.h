@@ -2,6 +2,7 @@
 #define INCLUDE_SPECTRAL_SPEC_BASIC_SPECTRUM_H
 #include <spectral/spec/spectrum.h>
 #include <spectral/spec/spectral_image.h>
+#include <spectral/spec/band_statistics.h>
 #include <spectral/internal/common/constants.h>
 #include <initializer_list>
 #include <unordered_map>
@@ -9,6 +10,10 @@
 
 namespace spec {
 
+    /**
+     *  Spectrum given by samples. Sorted set of wavelenghts is updated with every added sample,
+     * so const access never modifies spectrum and may be done from any number of threads.
+     */
     class BasicSpectrum : public ISpectrum
     {
     public: 
@@ -17,17 +22,19 @@ namespace spec {
         BasicSpectrum()
             : spectre() {}
 
-        BasicSpectrum(std::initializer_list<std::pair<const Float, Float>> l) 
-            : spectre(l) {get_wavelenghts();}
+        BasicSpectrum(std::initializer_list<std::pair<const Float, Float>> l);
 
         BasicSpectrum(const BasicSpectrum &s) = default;
 
         BasicSpectrum(BasicSpectrum &&s)
-            : ISpectrum(s), cached_wavelenghts(std::move(s.cached_wavelenghts)), modified(std::move(s.modified)), spectre(std::move(s.spectre)) {}
+            : ISpectrum(s), wavelenghts(std::move(s.wavelenghts)), spectre(std::move(s.spectre)) {}
 
         void set(Float wavelenght, Float value);
 
-        const std::set<Float> &get_wavelenghts() const;
+        const std::set<Float> &get_wavelenghts() const
+        {
+            return wavelenghts;
+        }
 
         Float &operator[](Float w);
 
@@ -37,6 +44,9 @@ namespace spec {
 
         Float get_or_interpolate(Float w) const override;
 
+        void sample_into(const Float *wavelenghts, size_t n, Float *out) const override;
+        void sample_into(Float start, Float step, size_t n, Float *out) const override;
+
         BasicSpectrum &operator=(const BasicSpectrum &other) = default;
         BasicSpectrum &operator=(BasicSpectrum &&other);
 
@@ -49,8 +59,7 @@ namespace spec {
         static const BasicSpectrum none;
 
     private:
-        mutable std::set<Float> cached_wavelenghts{};
-        mutable bool modified = true;
+        std::set<Float> wavelenghts{};
         std::unordered_map<Float, Float> spectre;
     };
 
@@ -61,6 +70,8 @@ namespace spec {
      *          png3, json3         - 3 channel png for each triplet of wavelenghts and metadata file
      *          png3_zip            - same as 'png3', but packet in zip archive
      *          one_spectre         - saves spectre of (0, 0) pixel in text format
+     *          envi, envi_bil, envi_bip - ENVI header and float32 raw file (.raw next to header),
+     *                                     '_be' suffix writes big-endian data, '.hdr' extension selects 'envi'
      * 
      *  If format is not specified (empty string is supplied), format will be choosen from name of file. 
      * If 'png1', or 'png3' format is used, path is interpreted as directory to save those files to,
@@ -81,13 +92,33 @@ namespace spec {
             : SpectralImage<BasicSpectrum>(w, h, p), wavelenghts(p.get_wavelenghts()) {} 
 
         BasicSpectralImage(const BasicSpectralImage &img)
-            : SpectralImage<BasicSpectrum>(img), wavelenghts(img.wavelenghts) {}
+            : SpectralImage<BasicSpectrum>(img), wavelenghts(img.wavelenghts), statistics(img.statistics) {}
 
         BasicSpectralImage(BasicSpectralImage &&image)
-            : SpectralImage<BasicSpectrum>(std::move(image)), wavelenghts(std::move(image.wavelenghts)) {}
+            : SpectralImage<BasicSpectrum>(std::move(image)), wavelenghts(std::move(image.wavelenghts)), statistics(std::move(image.statistics)) {}
 
         BasicSpectralImage &operator=(BasicSpectralImage &&other);
 
+        BasicSpectrum &at(int i, int j) override
+        {
+            invalidate_statistics();
+            return SpectralImage<BasicSpectrum>::at(i, j);
+        }
+
+        const BasicSpectrum &at(int i, int j) const override
+        {
+            return SpectralImage<BasicSpectrum>::at(i, j);
+        }
+
+        inline const BasicSpectrum *raw_data() const {
+            return data.data();
+        }
+
+        inline BasicSpectrum *raw_data() {
+            invalidate_statistics();
+            return data.data();
+        }
+
         void add_wavelenght(Float w);
         
         void remove_wavelenght(Float w);
@@ -107,12 +138,25 @@ namespace spec {
 
         bool save(const std::string &path, const std::string &format = "") const;
 
+        /**
+         *  Checks that every pixel has values only in wavelenghts of image.
+         */
         bool validate() const;
 
-        
+        /**
+         *  Returns cached statistics of bands present in any pixel, computes them in parallel
+         * if image was modified. Any non-const access invalidates cache.
+         */
+        BandStatistics::ptr get_band_statistics() const;
+
+        inline void invalidate_statistics()
+        {
+            if(statistics) statistics.reset();
+        }
 
     private:
         std::set<Float> wavelenghts;
+        mutable BandStatistics::ptr statistics{};
     };
 
 
@@ -2,9 +2,11 @@
 #define INCLUDE_SPECTRAL_SPEC_CONVERSIONS_H
 #include <spectral/internal/math/math.h>
 #include <spectral/spec/basic_spectrum.h>
+#include <spectral/spec/sigpoly_spectrum.h>
 #include <spectral/spec/spectral_util.h>
 #include <spectral/imageutil/image.h>
 #include <utility>
+#include <vector>
 
 namespace spec {
 
@@ -30,11 +32,17 @@ namespace spec {
         return xyz2cielab(rgb2xyz(rgb));
     }
 
+    /**
+     *  Conversions taking light compute util::compute_cmf_weights(light) on each call,
+     * overloads taking cmf_weights use table computed once by caller.
+     */
     vec3 spectre2xyz(const ISpectrum &spectre, const ISpectrum &light = util::CIE_D6500);
+    vec3 spectre2xyz(const ISpectrum &spectre, const std::vector<vec3> &cmf_weights);
 
     vec3 spectre2xyz0(const ISpectrum &spectre);
 
     Image spectral_image2rgb(const ISpectralImage &img, const ISpectrum &light = util::CIE_D6500);
+    Image spectral_image2rgb(const ISpectralImage &img, const std::vector<vec3> &cmf_weights);
 
 
     inline vec3 spectre2rgb(const ISpectrum &spectre, const ISpectrum &light = util::CIE_D6500)
@@ -42,8 +50,19 @@ namespace spec {
         return xyz2rgb(spectre2xyz(spectre, light));
     }
 
+    inline vec3 spectre2rgb(const ISpectrum &spectre, const std::vector<vec3> &cmf_weights)
+    {
+        return xyz2rgb(spectre2xyz(spectre, cmf_weights));
+    }
+
     vec3 sigpoly2xyz(Float a1, Float a2, Float a3);
 
+    /**
+     *  Converts count sigmoid polynomial spectra to XYZ at once. Uses AVX2 if supported by CPU.
+     */
+    void sigpoly2xyz(const SigPolySpectrum *src, size_t count, vec3 *dst, const ISpectrum &light = util::CIE_D6500);
+    void sigpoly2xyz(const SigPolySpectrum *src, size_t count, vec3 *dst, const std::vector<vec3> &cmf_weights);
+
 
     //Approximation based on http://jcgt.org/published/0003/04/03/paper.pdf
     std::pair<Float, Float> color2ior(Float reflectivity, Float edgetint);
@@ -0,0 +1,122 @@
+#ifndef INCLUDE_SPECTRAL_SPEC_DENSE_SPECTRAL_IMAGE_H
+#define INCLUDE_SPECTRAL_SPEC_DENSE_SPECTRAL_IMAGE_H
+#include <spectral/spec/spectrum.h>
+#include <spectral/spec/pixel_spectrum.h>
+#include <spectral/spec/band_statistics.h>
+#include <vector>
+
+namespace spec {
+
+    /**
+     *  Spectral image with one sorted wavelenght axis shared by all pixels and all values
+     * stored in one contiguous buffer.
+     *
+     *  PIXEL_INTERLEAVED - all bands of a pixel are stored together (same as ENVI BIP);
+     *  BAND_INTERLEAVED  - whole image is stored for each band (same as ENVI BSQ).
+     *
+     *  Band statistics are cached until non-const raw_data() or invalidate_statistics() is called.
+     * Non-const value() is a plain accessor, so code writing through it calls invalidate_statistics() once before.
+     */
+    class DenseSpectralImage : public ISpectralImage
+    {
+    public:
+        INJECT_REFL(DenseSpectralImage);
+
+        enum class Layout {PIXEL_INTERLEAVED, BAND_INTERLEAVED};
+
+        using SpectrumType = PixelSpectrum<DenseSpectralImage>;
+
+        DenseSpectralImage();
+
+        DenseSpectralImage(int w, int h, const std::vector<Float> &wavelenghts, Layout layout = Layout::PIXEL_INTERLEAVED);
+
+        DenseSpectralImage(const DenseSpectralImage &image);
+
+        DenseSpectralImage(DenseSpectralImage &&image);
+
+        DenseSpectralImage &operator=(const DenseSpectralImage &other);
+        DenseSpectralImage &operator=(DenseSpectralImage &&other);
+
+        SpectrumType &at(int i, int j) override;
+        const SpectrumType &at(int i, int j) const override;
+
+        const std::vector<Float> &get_wavelenghts() const
+        {
+            return wavelenghts;
+        }
+
+        int get_bands() const
+        {
+            return wavelenghts.size();
+        }
+
+        Layout get_layout() const
+        {
+            return layout;
+        }
+
+        long get_pixel_stride() const
+        {
+            return pixel_stride;
+        }
+
+        long get_band_stride() const
+        {
+            return band_stride;
+        }
+
+        /**
+         *  Returns index of band with specified wavelenght or -1 if there is no such band.
+         */
+        int find_band(Float w) const;
+
+        inline const Float *raw_data() const
+        {
+            return data.data();
+        }
+
+        inline Float *raw_data()
+        {
+            invalidate_statistics();
+            return data.data();
+        }
+
+        inline Float &value(long pixel, int band)
+        {
+            return data[pixel * pixel_stride + band * band_stride];
+        }
+
+        inline Float value(long pixel, int band) const
+        {
+            return data[pixel * pixel_stride + band * band_stride];
+        }
+
+        Float evaluate(long pixel, Float w) const;
+
+        /**
+         *  Returns cached band statistics, computes them in parallel if image was modified.
+         */
+        BandStatistics::ptr get_band_statistics() const;
+
+        inline void invalidate_statistics()
+        {
+            if(statistics) statistics.reset();
+        }
+
+    private:
+        std::vector<Float> wavelenghts;
+        Layout layout;
+        long pixel_stride;
+        long band_stride;
+        std::vector<Float> data;
+        std::vector<SpectrumType> spectra;
+        mutable BandStatistics::ptr statistics;
+
+        void bind_spectra();
+    };
+
+    extern template class PixelSpectrum<DenseSpectralImage>;
+
+}
+
+#endif
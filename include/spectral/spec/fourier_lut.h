@@ -2,9 +2,12 @@
 #define INCLUDE_SPECTRAL_SPEC_FOURIER_LUT_H
 #include <spectral/internal/math/math.h>
 #include <spectral/internal/math/fourier.h>
+#include <spectral/internal/common/mapped_file.h>
 #include <vector>
 #include <cinttypes>
 #include <istream>
+#include <ostream>
+#include <string>
 
 namespace spec {
     
@@ -14,25 +17,30 @@ namespace spec {
         static constexpr uint64_t FILE_MARKER = 0xfafa0000ab0ba001;
 
         FourierLUT(std::vector<Float> &&data, const std::vector<Float> &power_values, unsigned step, unsigned m) : step{step}, size{256 / step + 1 + (255 % step != 0)}, m{m},
-            power_values(power_values), data{std::move(data)} {}
+            power_values(power_values), data{std::move(data)}, file{}, raw{this->data.data()}, axes{} {build_axes();}
 
         FourierLUT(const std::vector<Float> &power_values, unsigned step, unsigned m) : step{step}, size{256 / step + 1 + (255 % step != 0)}, m{m},
-            power_values(power_values), data(power_values.size() * size * size * size * (m + 1)) {}
+            power_values(power_values), data(power_values.size() * size * size * size * (m + 1)), file{}, raw{data.data()}, axes{} {build_axes();}
 
-        FourierLUT() = default;
+        FourierLUT() : step{}, size{}, m{}, power_values{}, data{}, file{}, raw{}, axes{} {}
         
         FourierLUT(const FourierLUT &) = delete;
         FourierLUT &operator=(const FourierLUT &) = delete;
 
-        FourierLUT(FourierLUT &&other) : step{}, size{}, m{}, power_values{}, data{}
+        FourierLUT(FourierLUT &&other) : step{}, size{}, m{}, power_values{}, data{}, file{}, raw{}, axes{}
         {
             *this = std::move(other);
         }
 
         FourierLUT &operator=(FourierLUT &&other)
         {
+            //moving vector keeps its buffer, so raw stays valid
             data = std::move(other.data);
+            file = std::move(other.file);
+            raw = other.raw;
+            other.raw = nullptr;
             power_values = std::move(other.power_values);
+            axes = std::move(other.axes);
             std::swap(m, other.m);
             std::swap(step, other.step);
             std::swap(size, other.size);
@@ -61,21 +69,76 @@ namespace spec {
 
         const Float *get_raw_data() const
         {
-            return data.data();
+            return raw;
+        }
+
+        /**
+         *  True if data are used directly from memory mapped file.
+         */
+        bool is_mapped() const
+        {
+            return file != nullptr;
         }
 
         std::vector<Float> eval(int r, int g, int b, Float power) const;
 
+        /**
+         *  Writes get_m() + 1 coefficients to dst, does not allocate.
+         * Returns false and leaves dst untouched if color is out of range.
+         */
+        bool eval(int r, int g, int b, Float power, Float *dst) const;
+
+        /**
+         *  Evaluates count colors with their powers, writes get_m() + 1 coefficients per color to dst.
+         * Colors out of range (e.g. {-1, -1, -1}) produce zero coefficients.
+         */
+        void eval_batch(const vec3i *rgb, const Float *power, size_t count, Float *dst) const;
+
+        /**
+         *  Writes LUT in format v2.
+         */
+        void save_to(std::ostream &dst) const;
+
+        /**
+         *  Loads both v1 and v2 files.
+         */
         static FourierLUT load_from(std::istream &src);
 
+        /**
+         *  Files in format v2 are memory mapped and used without copying, v1 files are read as a stream.
+         */
+        static FourierLUT load_from_file(const std::string &path);
+
     private:
+        //interpolation indices and weights along one axis, precomputed for all channel values
+        struct Axis
+        {
+            unsigned id1, id2;
+            Float d, d1, d2;
+        };
+
         unsigned step;
         unsigned size;
         unsigned m;
         std::vector<Float> power_values;
         std::vector<Float> data;
+        MappedFile::ptr file;
+        const Float *raw;
+        std::vector<Axis> axes;
+
+        FourierLUT(MappedFile::ptr &&file, const Float *raw, const std::vector<Float> &power_values, unsigned step, unsigned m) : step{step}, size{256 / step + 1 + (255 % step != 0)}, m{m},
+            power_values(power_values), data{}, file{std::move(file)}, raw{raw}, axes{} {build_axes();}
+
+        size_t data_size() const
+        {
+            return power_values.size() * size_t(size) * size * size * (m + 1);
+        }
+
+        void build_axes();
+
+        void eval_to(const vec3i &rgb, Float power, Float *dst) const;
 
-        void add(std::vector<Float> &res, unsigned r, unsigned g, unsigned b, unsigned n, Float mul) const;
+        void add(Float *res, unsigned r, unsigned g, unsigned b, unsigned n, Float mul) const;
     };
 
 
@@ -2,11 +2,18 @@
 #define INCLUDE_SPECTRAL_SPEC_FOURIER_SPECTRUM_H
 #include <spectral/spec/spectrum.h>
 #include <spectral/spec/spectral_image.h>
+#include <spectral/spec/pixel_spectrum.h>
 #include <spectral/internal/math/fourier.h>
 #include <vector>
 
 namespace spec {
 
+    /**
+     *  Reflectance given by fourier coefficients, evaluated by bounded MESE. Lagrange multipliers
+     * are kept with coefficients and computed at construction, by set() and by precompute(). Const
+     * methods never write them, so the spectrum can be shared between threads. Non-const operator[]
+     * drops them and evaluation throws std::runtime_error until precompute() is called.
+     */
     class FourierReflectanceSpectrum : public ISpectrum 
     {
     public:
@@ -16,26 +23,34 @@ namespace spec {
             : coef{} {}
 
         FourierReflectanceSpectrum(const std::vector<Float> &coef)
-            : coef(coef) {}
+            : coef(coef)
+        {
+            precompute();
+        }
 
         FourierReflectanceSpectrum(std::vector<Float> &&coef)
-            : coef(std::move(coef)) {}
+            : coef(std::move(coef))
+        {
+            precompute();
+        }
 
         FourierReflectanceSpectrum(const FourierReflectanceSpectrum &other) = default;
 
         FourierReflectanceSpectrum(FourierReflectanceSpectrum &&other)
-            : coef(std::move(other.coef)) {}
+            : coef(std::move(other.coef)), lagrange_m(std::move(other.lagrange_m)) {}
 
         FourierReflectanceSpectrum &operator=(const FourierReflectanceSpectrum &other) = default;
 
         FourierReflectanceSpectrum &operator=(FourierReflectanceSpectrum &&other)
         {
             coef = std::move(other.coef);
+            lagrange_m = std::move(other.lagrange_m);
             return *this;
         }
 
         Float &operator[](unsigned i)
         {
+            lagrange_m.clear();
             return coef[i];
         }
 
@@ -52,21 +67,63 @@ namespace spec {
         void set(const std::vector<Float> &c)
         {
             coef = c;
+            lagrange_m.clear();
+            precompute();
         }
 
+        /**
+         *  Computes lagrange multipliers if they are not computed yet.
+         */
+        void precompute();
+
+        bool is_precomputed() const
+        {
+            return !lagrange_m.empty();
+        }
+
+        /**
+         *  Throws std::runtime_error if multipliers are not computed.
+         */
+        const std::vector<Complex> &get_lagrange_multipliers() const;
+
         Float get_or_interpolate(Float w) const override;
 
+        void sample_into(const Float *wavelenghts, size_t n, Float *out) const override;
+        void sample_into(Float start, Float step, size_t n, Float *out) const override;
+
 
     private:
         std::vector<Float> coef;
-        mutable std::vector<Complex> lagrange_m{};
+        std::vector<Complex> lagrange_m{};
     };
 
 
     extern template class SpectralImage<FourierReflectanceSpectrum>;
 
-    using FourierReflectanceSpectralImage = SpectralImage<FourierReflectanceSpectrum>;
+    /**
+     *  Image of fourier reflectances, lagrange multipliers of all pixels can be computed
+     * at once by precompute().
+     */
+    class FourierReflectanceSpectralImage : public SpectralImage<FourierReflectanceSpectrum>
+    {
+    public:
+        INJECT_REFL(FourierReflectanceSpectralImage);
+
+        using SpectralImage<FourierReflectanceSpectrum>::SpectralImage;
+
+        /**
+         *  Computes lagrange multipliers of all pixels in parallel.
+         */
+        void precompute();
+
+        bool is_precomputed() const;
+    };
 
+    /**
+     *  Emission given by fourier coefficients, evaluated by MESE. Its q-vector is kept the same way
+     * as lagrange multipliers of FourierReflectanceSpectrum, spectrum with zero coefficient 0
+     * has no q-vector and evaluates to 0.
+     */
     class FourierEmissionSpectrum : public ISpectrum 
     {
     public:
@@ -76,26 +133,34 @@ namespace spec {
             : coef{} {}
 
         FourierEmissionSpectrum(const std::vector<Float> &coef)
-            : coef(coef) {}
+            : coef(coef)
+        {
+            precompute();
+        }
 
         FourierEmissionSpectrum(std::vector<Float> &&coef)
-            : coef(std::move(coef)) {}
+            : coef(std::move(coef))
+        {
+            precompute();
+        }
 
         FourierEmissionSpectrum(const FourierEmissionSpectrum &other) = default;
 
         FourierEmissionSpectrum(FourierEmissionSpectrum &&other)
-            : coef(std::move(other.coef)) {}
+            : coef(std::move(other.coef)), q_vector(std::move(other.q_vector)) {}
 
         FourierEmissionSpectrum &operator=(const FourierEmissionSpectrum &other) = default;
 
         FourierEmissionSpectrum &operator=(FourierEmissionSpectrum &&other)
         {
             coef = std::move(other.coef);
+            q_vector = std::move(other.q_vector);
             return *this;
         }
 
         Float &operator[](unsigned i)
         {
+            q_vector.clear();
             return coef[i];
         }
 
@@ -112,20 +177,144 @@ namespace spec {
         void set(const std::vector<Float> &c)
         {
             coef = c;
+            q_vector.clear();
+            precompute();
+        }
+
+        /**
+         *  Computes q-vector if it is not computed yet.
+         */
+        void precompute();
+
+        bool is_precomputed() const
+        {
+            return !q_vector.empty();
         }
 
         Float get_or_interpolate(Float w) const override;
 
+        void sample_into(const Float *wavelenghts, size_t n, Float *out) const override;
+        void sample_into(Float start, Float step, size_t n, Float *out) const override;
+
+        /**
+         *  Writes values at all phases of grid to dst.
+         */
+        void sample(const math::PhaseGrid &grid, Float *dst) const;
+
+
+    private:
+        std::vector<Float> coef;
+        std::vector<Float> q_vector{};
+    };
+
+
+    /**
+     *  Emission spectra of whole image stored as m + 1 fourier coefficients per pixel in one buffer.
+     * MESE coefficients (q-vectors) are stored the same way, they are computed by precompute()
+     * and dropped by non-const raw_data(), coefficients(pixel) and invalidate_precomputed().
+     * Parallel writers take raw_data() once instead of calling coefficients(pixel) from threads.
+     * Evaluation of pixels with nonzero coefficients requires q-vectors and throws std::runtime_error without them.
+     */
+    class FourierEmissionSpectralImage : public ISpectralImage
+    {
+    public:
+        INJECT_REFL(FourierEmissionSpectralImage);
+
+        using SpectrumType = PixelSpectrum<FourierEmissionSpectralImage>;
+
+        FourierEmissionSpectralImage();
+
+        FourierEmissionSpectralImage(int w, int h, unsigned m);
+
+        FourierEmissionSpectralImage(const FourierEmissionSpectralImage &image);
+
+        FourierEmissionSpectralImage(FourierEmissionSpectralImage &&image);
+
+        FourierEmissionSpectralImage &operator=(const FourierEmissionSpectralImage &other);
+        FourierEmissionSpectralImage &operator=(FourierEmissionSpectralImage &&other);
+
+        SpectrumType &at(int i, int j) override;
+        const SpectrumType &at(int i, int j) const override;
+
+        unsigned get_m() const
+        {
+            return m;
+        }
+
+        unsigned get_stride() const
+        {
+            return m + 1;
+        }
+
+        inline const Float *raw_data() const
+        {
+            return coef.data();
+        }
+
+        inline Float *raw_data()
+        {
+            q.clear();
+            return coef.data();
+        }
+
+        inline const Float *coefficients(long pixel) const
+        {
+            return coef.data() + pixel * get_stride();
+        }
+
+        inline Float *coefficients(long pixel)
+        {
+            q.clear();
+            return coef.data() + pixel * get_stride();
+        }
+
+        inline void invalidate_precomputed()
+        {
+            q.clear();
+        }
+
+        /**
+         *  Computes q-vectors of all pixels in parallel, systems of neighbouring pixels are solved together.
+         */
+        void precompute();
+
+        bool is_precomputed() const
+        {
+            return !q.empty();
+        }
+
+        Float evaluate(long pixel, Float w) const;
+
+        /**
+         *  Writes values of pixel at all phases of grid to dst.
+         */
+        void sample(long pixel, const math::PhaseGrid &grid, Float *dst) const;
 
     private:
+        unsigned m;
         std::vector<Float> coef;
-        mutable std::vector<Float> q_vector{};
+        std::vector<Float> q;
+        std::vector<SpectrumType> spectra;
+
+        void bind_spectra();
     };
 
+    /**
+     *  Throws std::runtime_error if img is a fourier image which is not precomputed. Called before
+     * evaluating pixels in parallel loops, where the exception could not be propagated.
+     */
+    void require_precomputed(const ISpectralImage &img);
+
+    /**
+     *  Pixels are sampled by the image, which keeps their q-vectors.
+     */
+    template<>
+    void PixelSpectrum<FourierEmissionSpectralImage>::sample_into(const Float *wavelenghts, size_t n, Float *out) const;
 
-    extern template class SpectralImage<FourierEmissionSpectrum>;
+    template<>
+    void PixelSpectrum<FourierEmissionSpectralImage>::sample_into(Float start, Float step, size_t n, Float *out) const;
 
-    using FourierEmissionSpectralImage = SpectralImage<FourierEmissionSpectrum>;
+    extern template class PixelSpectrum<FourierEmissionSpectralImage>;
 /*
     class LFourierSpectrum : public ISpectrum 
     {
@@ -0,0 +1,63 @@
+#ifndef INCLUDE_SPECTRAL_SPEC_PIXEL_SPECTRUM_H
+#define INCLUDE_SPECTRAL_SPEC_PIXEL_SPECTRUM_H
+#include <spectral/spec/spectrum.h>
+
+namespace spec {
+
+    /**
+     *  Lightweight spectrum that refers to one pixel of image with flat storage.
+     * Does not own any data, all evaluation is forwarded to ImageType::evaluate(pixel, w).
+     */
+    template<typename ImageType>
+    class PixelSpectrum : public ISpectrum
+    {
+    public:
+        INJECT_REFL(PixelSpectrum<ImageType>);
+
+        PixelSpectrum() noexcept(true)
+            : image(nullptr), pixel(0) {}
+
+        PixelSpectrum(const PixelSpectrum &other) = default;
+        PixelSpectrum &operator=(const PixelSpectrum &other) = default;
+
+        Float get_or_interpolate(Float w) const override
+        {
+            return image->evaluate(pixel, w);
+        }
+
+        /**
+         *  Sample one wavelenght at a time, images which can do better specialize them.
+         */
+        void sample_into(const Float *wavelenghts, size_t n, Float *out) const override
+        {
+            ISpectrum::sample_into(wavelenghts, n, out);
+        }
+
+        void sample_into(Float start, Float step, size_t n, Float *out) const override
+        {
+            ISpectrum::sample_into(start, step, n, out);
+        }
+
+        const ImageType &get_image() const
+        {
+            return *image;
+        }
+
+        long get_pixel() const
+        {
+            return pixel;
+        }
+
+    private:
+        friend ImageType;
+
+        PixelSpectrum(const ImageType *image, long pixel) noexcept(true)
+            : image(image), pixel(pixel) {}
+
+        const ImageType *image;
+        long pixel;
+    };
+
+}
+
+#endif
@@ -0,0 +1,78 @@
+#ifndef INCLUDE_SPECTRAL_SPEC_SAMPLED_SPECTRUM_H
+#define INCLUDE_SPECTRAL_SPEC_SAMPLED_SPECTRUM_H
+#include <spectral/spec/spectrum.h>
+#include <initializer_list>
+#include <utility>
+#include <vector>
+
+namespace spec {
+
+    /**
+     *  Spectrum stored as (wavelenght, value) pairs sorted by wavelenght.
+     * If wavelenghts form uniform grid, interpolation does not search for the interval.
+     * Interpolation rules are the same as in BasicSpectrum.
+     */
+    class SampledSpectrum : public ISpectrum
+    {
+    public:
+        INJECT_REFL(SampledSpectrum);
+
+        using SampleType = std::pair<Float, Float>;
+
+        SampledSpectrum()
+            : samples(), uniform(false), step(0.0f), inv_step(0.0f) {}
+
+        SampledSpectrum(std::initializer_list<SampleType> l);
+
+        SampledSpectrum(const std::vector<Float> &wavelenghts, const std::vector<Float> &values);
+
+        /**
+         *  Creates spectrum on uniform grid start, start + step, ...
+         */
+        SampledSpectrum(Float start, Float step, const std::vector<Float> &values);
+
+        void set(Float wavelenght, Float value);
+
+        /**
+         *  Returns value at exactly specified wavelenght. Throws std::out_of_range if there is no such sample.
+         */
+        Float operator[](Float w) const;
+
+        Float get_or_interpolate(Float w) const override;
+
+        void sample_into(const Float *wavelenghts, size_t n, Float *out) const override;
+        void sample_into(Float start, Float step, size_t n, Float *out) const override;
+
+        const std::vector<SampleType> &get_samples() const
+        {
+            return samples;
+        }
+
+        size_t size() const
+        {
+            return samples.size();
+        }
+
+        bool is_uniform() const
+        {
+            return uniform;
+        }
+
+        void reserve(size_t count)
+        {
+            samples.reserve(count);
+        }
+
+    private:
+        std::vector<SampleType> samples;
+        bool uniform;
+        Float step;
+        Float inv_step;
+
+        void update_grid();
+        bool fits_grid(Float delta) const;
+    };
+
+}
+
+#endif
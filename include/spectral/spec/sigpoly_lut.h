@@ -1,9 +1,13 @@
 #ifndef INCLUDE_SPECTRAL_SPEC_SIGPOLY_LUT_H
 #define INCLUDE_SPECTRAL_SPEC_SIGPOLY_LUT_H
 #include <spectral/internal/math/math.h>
+#include <spectral/imageutil/pixel.h>
+#include <spectral/internal/common/mapped_file.h>
 #include <vector>
 #include <cinttypes>
 #include <istream>
+#include <ostream>
+#include <string>
 
 namespace spec {
     
@@ -12,21 +16,25 @@ namespace spec {
     public:
         static constexpr uint64_t FILE_MARKER = 0xfafa0000ab0ba000;
 
-        SigpolyLUT(std::vector<vec3> &&data, unsigned step) : step{step}, size{256 / step + (255 % step != 0)}, data{std::move(data)} {}
+        SigpolyLUT(std::vector<vec3> &&data, unsigned step) : step{step}, size{256 / step + (255 % step != 0)}, data{std::move(data)}, file{}, raw{this->data.data()} {}
 
-        SigpolyLUT(unsigned step) : step{step}, size{256 / step + (255 % step != 0)}, data(size * size * size) {}
+        SigpolyLUT(unsigned step) : step{step}, size{256 / step + (255 % step != 0)}, data(size * size * size), file{}, raw{data.data()} {}
 
         SigpolyLUT(const SigpolyLUT &) = delete;
         SigpolyLUT &operator=(const SigpolyLUT &) = delete;
 
-        SigpolyLUT(SigpolyLUT &&other) : step{}, size{}, data{}
+        SigpolyLUT(SigpolyLUT &&other) : step{}, size{}, data{}, file{}, raw{}
         {
             *this = std::move(other);
         }
 
         SigpolyLUT &operator=(SigpolyLUT &&other)
         {
+            //moving vector keeps its buffer, so raw stays valid
             data = std::move(other.data);
+            file = std::move(other.file);
+            raw = other.raw;
+            other.raw = nullptr;
             std::swap(step, other.step);
             std::swap(size, other.size);
             return *this;
@@ -44,25 +52,97 @@ namespace spec {
 
         const vec3 *get_raw_data() const
         {
-            return data.data();
+            return raw;
+        }
+
+        /**
+         *  True if data are used directly from memory mapped file.
+         */
+        bool is_mapped() const
+        {
+            return file != nullptr;
         }
 
         vec3 eval(int a, int b, int alpha) const;
 
+        /**
+         *  Writes LUT in format v2.
+         */
+        void save_to(std::ostream &dst) const;
+
+        /**
+         *  Loads both v1 and v2 files.
+         */
         static SigpolyLUT load_from(std::istream &src);
 
+        /**
+         *  Files in format v2 are memory mapped and used without copying, v1 files are read as a stream.
+         */
+        static SigpolyLUT load_from_file(const std::string &path);
+
     private:
         unsigned step;
         unsigned size;
         std::vector<vec3> data;
+        MappedFile::ptr file;
+        const vec3 *raw;
+
+        SigpolyLUT(MappedFile::ptr &&file, const vec3 *raw, unsigned step) : step{step}, size{256 / step + (255 % step != 0)}, data{}, file{std::move(file)}, raw{raw} {}
 
         const vec3 &at(int i, int j, int k) const
         {
-            return data[((k * size) + i) * size + j];
+            return raw[((k * size) + i) * size + j];
         }
         Float aid_to_alpha(int c) const;
     };
 
+    /**
+     *  Three LUTs (one per maximal channel) evaluated together on whole pixels.
+     * Coefficients are read in place from LUT data (mapped file for v2 LUTs),
+     * all per-channel indices and weights are precomputed for 256 possible values,
+     * so evaluation needs no divisions by step nor inverse smoothstep.
+     * Results are identical to SigpolyLUT::eval after normalization done in upsample::sigpoly_int.
+     */
+    class SigpolyLUTSet
+    {
+    public:
+        /**
+         *  Takes ownership of LUTs, all of them have to share the same step.
+         */
+        SigpolyLUTSet(SigpolyLUT &&lut0, SigpolyLUT &&lut1, SigpolyLUT &&lut2);
+
+        vec3 eval(const Pixel &pixel) const;
+
+        /**
+         *  Writes 3 coefficients per pixel to dst. Uses AVX2 if supported by CPU.
+         */
+        void eval_batch(const Pixel *src, size_t count, Float *dst) const;
+
+    private:
+        static constexpr unsigned TABLE_SIZE = 256;
+
+        SigpolyLUT luts[3];
+
+        //all offsets are in Floats (3 per LUT entry)
+        //a ids are premultiplied by size
+        int32_t a_off1[TABLE_SIZE];
+        int32_t a_off2[TABLE_SIZE];
+        int32_t b_off1[TABLE_SIZE];
+        int32_t b_off2[TABLE_SIZE];
+        Float ab_d[TABLE_SIZE];
+        Float ab_d1[TABLE_SIZE];
+        Float ab_d2[TABLE_SIZE];
+        //alpha ids are premultiplied by size^2
+        int32_t alpha_off1[TABLE_SIZE];
+        int32_t alpha_off2[TABLE_SIZE];
+        Float alpha_d[TABLE_SIZE];
+        Float alpha_d1[TABLE_SIZE];
+        Float alpha_d2[TABLE_SIZE];
+
+        void eval_to(const Pixel &pixel, Float *dst) const;
+        void eval_batch_avx2(const Pixel *src, size_t count, Float *dst) const;
+    };
+
 
 }
 
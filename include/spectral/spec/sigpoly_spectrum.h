@@ -41,6 +41,9 @@ namespace spec {
 
         Float get_or_interpolate(Float w) const override;
 
+        void sample_into(const Float *wavelenghts, size_t n, Float *out) const override;
+        void sample_into(Float start, Float step, size_t n, Float *out) const override;
+
         SigPolySpectrum &operator=(const SigPolySpectrum &other) = default;
 
     private:
@@ -1,9 +1,13 @@
 #ifndef INCLUDE_SPECTRAL_SPEC_SPECTRAL_UTIL_H
 #define INCLUDE_SPECTRAL_SPEC_SPECTRAL_UTIL_H
 #include <spectral/spec/basic_spectrum.h>
+#include <spectral/spec/sampled_spectrum.h>
 #include <spectral/spec/sigpoly_spectrum.h>
+#include <spectral/spec/dense_spectral_image.h>
+#include <spectral/internal/serialization/envi.h>
 #include <string>
 #include <vector>
+#include <memory>
 #include <ostream>
 #include <istream>
 #include <cinttypes>
@@ -11,7 +15,7 @@
 namespace spec::util
 {
 
-    extern const BasicSpectrum CIE_D6500;
+    extern const SampledSpectrum CIE_D6500;
 
     extern const std::string META_FILENAME;
 
@@ -41,8 +45,19 @@ namespace spec::util
     Float get_cie_y_integral();
     Float get_cie_y_integral(const ISpectrum &light);
 
+    using CMFWeights = std::shared_ptr<const std::vector<vec3>>;
 
-    BasicSpectrum convert_to_spd(const ISpectrum &spectrum, const std::vector<Float> &wavelenghts = {});
+    /**
+     *  Computes CIE CMFs multiplied by light and divided by integral of Y * light, one vec3 for each wavelenght
+     * WAVELENGHTS_START, WAVELENGHTS_START + WAVELENGHTS_STEP, ..., WAVELENGHTS_END.
+     *
+     *  Nothing is cached except the table of CIE_D6500 object itself (copies of it are computed as any other light),
+     * code converting many spectra under one light computes the table once and uses conversion overloads taking cmf_weights.
+     */
+    CMFWeights compute_cmf_weights(const ISpectrum &light);
+
+
+    SampledSpectrum convert_to_spd(const ISpectrum &spectrum, const std::vector<Float> &wavelenghts = {});
 
 
     struct SavingResult
@@ -74,6 +89,7 @@ namespace spec::util
 
 
     void save_spd(const std::string &path, const BasicSpectrum &spectre);
+    void save_spd(const std::string &path, const SampledSpectrum &spectre);
 
     /**
      *  Saves specified wavelenghts of spectral image in multichannel png file (up to 4 channels).
@@ -85,21 +101,48 @@ namespace spec::util
     void save_wavelenght_to_png1(std::ostream &stream, const BasicSpectralImage &img, Float wavelenght, SavingResult &res);
 
     bool save_as_png1(const BasicSpectralImage &image, const std::string &dir, const std::string &meta_filename = META_FILENAME, const ISpectrum &lightsource = CIE_D6500);
+    bool save_as_png1(const DenseSpectralImage &image, const std::string &dir, const std::string &meta_filename = META_FILENAME, const ISpectrum &lightsource = CIE_D6500);
+
+    /**
+     *  Saves image as ENVI header and float32 raw data, values are written in bulk in requested interleave and byte order.
+     * Illuminant is stored in header with its own wavelenghts, as expected by load_envi_hdr.
+     */
+    bool save_envi_hdr(const DenseSpectralImage &image, const std::string &meta_path, const std::string &raw_path,
+                       MetaENVI::Interleave interleave = MetaENVI::Interleave::BSQ, MetaENVI::ByteOrder byte_order = MetaENVI::ByteOrder::LITTLE_ENDIAN_ORDER,
+                       const ISpectrum &lightsource = CIE_D6500);
+    bool save_envi_hdr(const BasicSpectralImage &image, const std::string &meta_path, const std::string &raw_path,
+                       MetaENVI::Interleave interleave = MetaENVI::Interleave::BSQ, MetaENVI::ByteOrder byte_order = MetaENVI::ByteOrder::LITTLE_ENDIAN_ORDER,
+                       const ISpectrum &lightsource = CIE_D6500);
+    /**
+     *  Images without own bands (sigmoid polynomial, Fourier) are sampled on CIE wavelenghts one line at a time.
+     */
+    bool save_envi_hdr(const ISpectralImage &image, const std::string &meta_path, const std::string &raw_path,
+                       MetaENVI::Interleave interleave = MetaENVI::Interleave::BSQ, MetaENVI::ByteOrder byte_order = MetaENVI::ByteOrder::LITTLE_ENDIAN_ORDER,
+                       const ISpectrum &lightsource = CIE_D6500);
+
+    /**
+     *  Accepts "envi" (band sequential), "envi_bsq", "envi_bil" and "envi_bip", optionally followed by "_be" for big-endian data.
+     */
+    bool parse_envi_format(const std::string &format, MetaENVI::Interleave &interleave, MetaENVI::ByteOrder &byte_order);
 
     bool save_sigpoly(const std::string path, const SigPolySpectrum &spectrum);
     bool save_sigpoly_img(const std::string path, const SigPolySpectralImage &img);
 
     bool save(const std::string &directory_path, const std::string &input_filename, const ISpectrum &s);
-    bool save(const std::string &directory_path, const std::string &input_filename, const ISpectralImage &s);
+    /**
+     *  Empty format keeps default format of image type. ENVI formats (see parse_envi_format) are supported for all images,
+     * images without own bands are sampled on CIE wavelenghts.
+     */
+    bool save(const std::string &directory_path, const std::string &input_filename, const ISpectralImage &s, const std::string &format = "");
 
 
-    BasicSpectrum load_spd(const std::string &path);
-    BasicSpectrum load_spd(const std::string &path, ISpectrum::csptr &lightsource);
+    SampledSpectrum load_spd(const std::string &path);
+    SampledSpectrum load_spd(const std::string &path, ISpectrum::csptr &lightsource);
 
-    BasicSpectralImage load_jsonmeta(const std::string &meta_path, ISpectrum::csptr &lightsource);
+    DenseSpectralImage load_json_meta(const std::string &meta_path, ISpectrum::csptr &lightsource);
 
-    BasicSpectralImage load_envi_hdr(const std::string &meta_path, const std::string &raw_path, ISpectrum::csptr &lightsource);
-    BasicSpectralImage load_envi_hdr(const std::string &meta_path, ISpectrum::csptr &lightsource);
+    DenseSpectralImage load_envi_hdr(const std::string &meta_path, const std::string &raw_path, ISpectrum::csptr &lightsource);
+    DenseSpectralImage load_envi_hdr(const std::string &meta_path, ISpectrum::csptr &lightsource);
     SigPolySpectrum load_sigpoly(const std::string &path, ISpectrum::csptr &lightsource);
     SigPolySpectralImage load_sigpoly_img(const std::string &path,  ISpectrum::csptr &lightsource);
 
@@ -3,6 +3,7 @@
 #include <spectral/internal/math/math.h>
 #include <spectral/internal/common/refl.h>
 #include <memory>
+#include <cstddef>
 
 namespace spec {
 
@@ -13,6 +14,27 @@ namespace spec {
 
         virtual Float get_or_interpolate(Float w) const = 0;
         Float operator()(Float w) const { return get_or_interpolate(w); }
+
+        /**
+         *  Writes values at n wavelenghts to out. Spectra override it to do their setup
+         * once per call, default calls get_or_interpolate for each wavelenght.
+         */
+        virtual void sample_into(const Float *wavelenghts, size_t n, Float *out) const
+        {
+            for(size_t i = 0; i < n; ++i) {
+                out[i] = get_or_interpolate(wavelenghts[i]);
+            }
+        }
+
+        /**
+         *  Same as above for wavelenghts start, start + step, ..., start + (n - 1) * step.
+         */
+        virtual void sample_into(Float start, Float step, size_t n, Float *out) const
+        {
+            for(size_t i = 0; i < n; ++i) {
+                out[i] = get_or_interpolate(start + i * step);
+            }
+        }
         virtual ~ISpectrum() = default;
 
         static const ISpectrum &none();
@@ -4,23 +4,28 @@
 #include <spectral/spec/fourier_lut.h>
 #include <spectral/spec/fourier_spectrum.h>
 
-#error "Invalid header code"
-
 namespace spec {
     class FourierUpsampler : public IUpsampler
     {
     public:
-        FourierUpsampler(bool emiss);
-        FourierUpsampler(FourierLUT &&lut, bool emiss)
-            : lut{std::move(lut)}, emiss{emiss} {}
+        static constexpr Float DEFAULT_POWER = 25.0f;
+
+        FourierUpsampler(bool emiss, Float power = DEFAULT_POWER);
+        FourierUpsampler(FourierLUT &&lut, bool emiss, Float power = DEFAULT_POWER)
+            : lut{std::move(lut)}, emiss{emiss}, power{power} {}
 
         ISpectralImage::ptr upsample(const Image &sourceImage) const override;
         ISpectrum::ptr upsample_pixel(const Pixel &src) const override;
+        //batch output is lut.get_m() + 1 fourier coefficients
+        unsigned get_batch_stride() const override;
+        void upsample_batch(const Pixel *src, size_t count, Float *dst) const override;
+        void upsample_batch(const vec3 *src, size_t count, Float *dst) const override;
         ~FourierUpsampler() = default;
     private:
         const FourierLUT lut;
         const bool emiss;
+        const Float power;
     };
 }
 
-#endif
\ No newline at end of file
+#endif
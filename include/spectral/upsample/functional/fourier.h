@@ -7,6 +7,16 @@
 
 namespace spec::upsample {
 
+    /**
+     *  Writes lut.get_m() + 1 fourier coefficients to dst.
+     */
+    void fourier_emiss_int(const Pixel &pixel, Float power, const FourierLUT &lut, Float *dst);
+
+    /**
+     *  Writes lut.get_m() + 1 fourier coefficients per pixel to dst, does not allocate.
+     */
+    void fourier_emiss_int(const Pixel *pixels, size_t count, Float power, const FourierLUT &lut, Float *dst);
+
     FourierEmissionSpectrum fourier_emiss_int(const Pixel &pixel, Float power, const FourierLUT &lut);
     inline FourierEmissionSpectrum fourier_emiss(const vec3 &rgb, Float power, const FourierLUT &lut) { return fourier_emiss_int(Pixel::from_vec3(rgb), power, lut); }
     inline FourierEmissionSpectrum fourier_emiss(Float r, Float g, Float b, Float power, const FourierLUT &lut) { return fourier_emiss({r, g, b}, power, lut); }
@@ -1,6 +1,6 @@
 #ifndef INCLUDE_SPECTRAL_UPSAMPLE_FUNCTIONAL_GLASSNER_H
 #define INCLUDE_SPECTRAL_UPSAMPLE_FUNCTIONAL_GLASSNER_H
-#include <spectral/spec/basic_spectrum.h>
+#include <spectral/spec/sampled_spectrum.h>
 #include <spectral/internal/math/math.h>
 
 namespace spec::upsample {
@@ -9,8 +9,13 @@ namespace spec::upsample {
     constexpr size_t GLASSNER_SPECTRUM_SIZE = 3ul;
 
 
-    BasicSpectrum glassner(const vec3 &rgb);
-    inline BasicSpectrum glassner(Float r, Float g, Float b) { return glassner({r, g, b}); }
+    /**
+     *  Writes GLASSNER_SPECTRUM_SIZE values for GLASSNER_WAVELENGHTS (in the same order) to dst.
+     */
+    void glassner(const vec3 &rgb, Float *dst);
+
+    SampledSpectrum glassner(const vec3 &rgb);
+    inline SampledSpectrum glassner(Float r, Float g, Float b) { return glassner({r, g, b}); }
 
 }
 
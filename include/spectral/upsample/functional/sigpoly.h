@@ -7,6 +7,11 @@
 
 namespace spec::upsample {
 
+    /**
+     *  Writes 3 coefficients of sigmoid polynomial to dst.
+     */
+    void sigpoly_int(const Pixel &pixel, const SigpolyLUT lut[3], Float *dst);
+
     SigPolySpectrum sigpoly_int(const Pixel &pixel, const SigpolyLUT lut[3]);
     inline SigPolySpectrum sigpoly(const vec3 &rgb, const SigpolyLUT lut[3]) { return sigpoly_int(Pixel::from_vec3(rgb), lut); }
     inline SigPolySpectrum sigpoly(Float r, Float g, Float b, const SigpolyLUT lut[3]) { return sigpoly({r, g, b}, lut); }
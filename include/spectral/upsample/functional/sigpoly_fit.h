@@ -0,0 +1,283 @@
+#ifndef INCLUDE_SPECTRAL_UPSAMPLE_FUNCTIONAL_SIGPOLY_FIT_H
+#define INCLUDE_SPECTRAL_UPSAMPLE_FUNCTIONAL_SIGPOLY_FIT_H
+#include <spectral/internal/math/math.h>
+#include <spectral/internal/common/constants.h>
+#include <spectral/spec/spectral_util.h>
+#include <spectral/spec/conversions.h>
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+namespace spec::upsample {
+
+    /**
+     *  Levenberg-Marquardt fit of 3 sigmoid polynomial coefficients to colour. Residual is difference
+     * of CIELAB colours, the same one the LUT generator minimizes. Jacobian is analytic and
+     * all state lives in the object and on stack, so one const object may be used from any number of threads.
+     */
+    class SigpolyFit
+    {
+    public:
+        static constexpr int SAMPLES = (WAVELENGHTS_END - WAVELENGHTS_START) / WAVELENGHTS_STEP + 1;
+
+        struct Options
+        {
+            int max_iterations = 100;
+            double function_tolerance = 1e-6;  //relative decrease of cost
+            double gradient_tolerance = 1e-10; //max norm of gradient
+            double parameter_tolerance = 1e-8; //step relative to coefficients
+        };
+
+        struct Summary
+        {
+            int iterations = 0;
+            double initial_cost = 0.0;
+            double final_cost = 0.0;
+            bool converged = false;
+        };
+
+        /**
+         *  CMFs under D65 in double precision.
+         */
+        SigpolyFit();
+
+        /**
+         *  One weight per CIE wavelenght, e. g. *util::compute_cmf_weights(light).
+         */
+        explicit SigpolyFit(const std::vector<vec3> &cmf_weights);
+
+        /**
+         *  Fits coefficients x to rgb colour, x is used as initial guess.
+         */
+        Summary solve(const vec3 &rgb, vec3d &x, const Options &options) const;
+
+        Summary solve(const vec3 &rgb, vec3d &x) const
+        {
+            return solve(rgb, x, Options{});
+        }
+
+        Summary solve_lab(const vec3d &lab, vec3d &x, const Options &options) const;
+
+        /**
+         *  Writes residual of coefficients x against target CIELAB colour and its jacobian (if not null).
+         */
+        void evaluate(const double x[3], const double target[3], double residual[3], double jacobian[3][3]) const;
+
+    private:
+        static constexpr double WHITE_POINT[3]{95.0489, 100.0, 108.8840};
+
+        double wl[SAMPLES];
+        double weights[SAMPLES][3];
+
+        static void _cielab_f(double t, double &f, double &df);
+        static bool _solve3(const double a[3][3], const double b[3], double x[3]);
+    };
+
+    inline SigpolyFit::SigpolyFit()
+    {
+        const double cieyint = util::get_cie_y_integral();
+        for(int i = 0; i < SAMPLES; ++i) {
+            wl[i] = WAVELENGHTS_START + i * WAVELENGHTS_STEP;
+            const double light = util::CIE_D6500.get_or_interpolate(wl[i]);
+            weights[i][0] = light * X_CURVE[i] / cieyint;
+            weights[i][1] = light * Y_CURVE[i] / cieyint;
+            weights[i][2] = light * Z_CURVE[i] / cieyint;
+        }
+    }
+
+    inline SigpolyFit::SigpolyFit(const std::vector<vec3> &cmf_weights)
+    {
+        for(int i = 0; i < SAMPLES; ++i) {
+            wl[i] = WAVELENGHTS_START + i * WAVELENGHTS_STEP;
+            weights[i][0] = cmf_weights[i].x;
+            weights[i][1] = cmf_weights[i].y;
+            weights[i][2] = cmf_weights[i].z;
+        }
+    }
+
+    inline void SigpolyFit::_cielab_f(double t, double &f, double &df)
+    {
+        constexpr double delta = 6.0 / 29.0;
+        constexpr double delta3 = delta * delta * delta;
+        constexpr double slope = 1.0 / (3.0 * delta * delta);
+
+        if(t - delta3 > EPSILON) {
+            f = std::cbrt(t);
+            df = 1.0 / (3.0 * f * f);
+        }
+        else {
+            f = t * slope + 4.0 / 29.0;
+            df = slope;
+        }
+    }
+
+    inline void SigpolyFit::evaluate(const double x[3], const double target[3], double residual[3], double jacobian[3][3]) const
+    {
+        double xyz[3]{0.0, 0.0, 0.0};
+        double dxyz[3][3]{};
+
+        for(int i = 0; i < SAMPLES; ++i) {
+            const double w = wl[i];
+            const double p = std::fma(std::fma(x[0], w, x[1]), w, x[2]);
+            const double r = std::sqrt(std::fma(p, p, 1.0));
+            const double s = std::fma(0.5, p / r, 0.5);
+            for(int c = 0; c < 3; ++c) {
+                xyz[c] += weights[i][c] * s;
+            }
+            if(jacobian) {
+                const double ds = 0.5 / (r * r * r);
+                for(int c = 0; c < 3; ++c) {
+                    const double g = weights[i][c] * ds;
+                    dxyz[c][0] += g * w * w;
+                    dxyz[c][1] += g * w;
+                    dxyz[c][2] += g;
+                }
+            }
+        }
+
+        double f[3], df[3];
+        for(int c = 0; c < 3; ++c) {
+            _cielab_f(xyz[c] / WHITE_POINT[c], f[c], df[c]);
+            df[c] /= WHITE_POINT[c];
+        }
+        residual[0] = 116.0 * f[1] - 16.0 - target[0];
+        residual[1] = 500.0 * (f[0] - f[1]) - target[1];
+        residual[2] = 200.0 * (f[1] - f[2]) - target[2];
+
+        if(jacobian) {
+            for(int k = 0; k < 3; ++k) {
+                jacobian[0][k] = 116.0 * df[1] * dxyz[1][k];
+                jacobian[1][k] = 500.0 * (df[0] * dxyz[0][k] - df[1] * dxyz[1][k]);
+                jacobian[2][k] = 200.0 * (df[1] * dxyz[1][k] - df[2] * dxyz[2][k]);
+            }
+        }
+    }
+
+    inline bool SigpolyFit::_solve3(const double a[3][3], const double b[3], double x[3])
+    {
+        //cholesky decomposition, matrix is symmetric positive definite unless step is degenerate
+        double l[3][3]{};
+        for(int i = 0; i < 3; ++i) {
+            for(int j = 0; j <= i; ++j) {
+                double sum = a[i][j];
+                for(int k = 0; k < j; ++k) sum -= l[i][k] * l[j][k];
+                if(i == j) {
+                    if(!(sum > 0.0)) return false;
+                    l[i][i] = std::sqrt(sum);
+                }
+                else {
+                    l[i][j] = sum / l[j][j];
+                }
+            }
+        }
+
+        double y[3];
+        for(int i = 0; i < 3; ++i) {
+            double sum = b[i];
+            for(int k = 0; k < i; ++k) sum -= l[i][k] * y[k];
+            y[i] = sum / l[i][i];
+        }
+        for(int i = 2; i >= 0; --i) {
+            double sum = y[i];
+            for(int k = i + 1; k < 3; ++k) sum -= l[k][i] * x[k];
+            x[i] = sum / l[i][i];
+        }
+        return true;
+    }
+
+    inline SigpolyFit::Summary SigpolyFit::solve(const vec3 &rgb, vec3d &x, const Options &options) const
+    {
+        const vec3 lab = rgb2cielab(rgb);
+        return solve_lab({lab.x, lab.y, lab.z}, x, options);
+    }
+
+    inline SigpolyFit::Summary SigpolyFit::solve_lab(const vec3d &lab, vec3d &x, const Options &options) const
+    {
+        //damping is scaled by diagonal of J^T J, limits are the same as in Ceres
+        constexpr double MIN_DIAGONAL = 1e-6;
+        constexpr double MAX_DIAGONAL = 1e32;
+
+        Summary summary;
+        double r[3], jac[3][3];
+        evaluate(x.v, lab.v, r, jac);
+        double cost = 0.5 * (r[0] * r[0] + r[1] * r[1] + r[2] * r[2]);
+        summary.initial_cost = cost;
+
+        double mu = 1e-4;
+        double nu = 2.0;
+        for(int it = 0; it < options.max_iterations; ++it) {
+            summary.iterations = it + 1;
+
+            double g[3], a[3][3];
+            for(int i = 0; i < 3; ++i) {
+                g[i] = jac[0][i] * r[0] + jac[1][i] * r[1] + jac[2][i] * r[2];
+                for(int j = 0; j < 3; ++j) {
+                    a[i][j] = jac[0][i] * jac[0][j] + jac[1][i] * jac[1][j] + jac[2][i] * jac[2][j];
+                }
+            }
+            if(std::max({std::abs(g[0]), std::abs(g[1]), std::abs(g[2])}) <= options.gradient_tolerance) {
+                summary.converged = true;
+                break;
+            }
+
+            double damped[3][3], minus_g[3]{-g[0], -g[1], -g[2]}, h[3];
+            std::copy(&a[0][0], &a[0][0] + 9, &damped[0][0]);
+            for(int i = 0; i < 3; ++i) {
+                damped[i][i] += mu * std::clamp(a[i][i], MIN_DIAGONAL, MAX_DIAGONAL);
+            }
+            if(!_solve3(damped, minus_g, h)) {
+                mu *= nu;
+                nu *= 2.0;
+                continue;
+            }
+
+            const double h_norm = std::sqrt(h[0] * h[0] + h[1] * h[1] + h[2] * h[2]);
+            const double x_norm = std::sqrt(x.v[0] * x.v[0] + x.v[1] * x.v[1] + x.v[2] * x.v[2]);
+            if(h_norm <= options.parameter_tolerance * (x_norm + options.parameter_tolerance)) {
+                summary.converged = true;
+                break;
+            }
+
+            double x_new[3]{x.v[0] + h[0], x.v[1] + h[1], x.v[2] + h[2]};
+            double r_new[3], jac_new[3][3];
+            evaluate(x_new, lab.v, r_new, jac_new);
+            const double new_cost = 0.5 * (r_new[0] * r_new[0] + r_new[1] * r_new[1] + r_new[2] * r_new[2]);
+
+            //decrease predicted by linear model
+            double model = 0.0;
+            for(int i = 0; i < 3; ++i) {
+                const double ah = a[i][0] * h[0] + a[i][1] * h[1] + a[i][2] * h[2];
+                model -= g[i] * h[i] + 0.5 * h[i] * ah;
+            }
+
+            if(std::isfinite(new_cost) && new_cost < cost) {
+                const double rho = model > 0.0 ? (cost - new_cost) / model : 1.0;
+                const double decrease = (cost - new_cost) / cost;
+
+                std::copy(x_new, x_new + 3, x.v);
+                std::copy(r_new, r_new + 3, r);
+                std::copy(&jac_new[0][0], &jac_new[0][0] + 9, &jac[0][0]);
+                cost = new_cost;
+
+                const double t = 2.0 * rho - 1.0;
+                mu *= std::max(1.0 / 3.0, 1.0 - t * t * t);
+                nu = 2.0;
+
+                if(decrease <= options.function_tolerance) {
+                    summary.converged = true;
+                    break;
+                }
+            }
+            else {
+                mu *= nu;
+                nu *= 2.0;
+            }
+        }
+
+        summary.final_cost = cost;
+        return summary;
+    }
+
+}
+
+#endif
@@ -1,6 +1,6 @@
 #ifndef INCLUDE_SPECTRAL_UPSAMPLE_FUNCTIONAL_SMITS_H
 #define INCLUDE_SPECTRAL_UPSAMPLE_FUNCTIONAL_SMITS_H
-#include <spectral/spec/basic_spectrum.h>
+#include <spectral/spec/sampled_spectrum.h>
 #include <spectral/internal/math/math.h>
 
 namespace spec::upsample {
@@ -11,8 +11,13 @@ namespace spec::upsample {
     };
     constexpr size_t SMITS_SPECTRUM_SIZE = sizeof(SMITS_WAVELENGHTS) / sizeof(Float); 
 
-    BasicSpectrum smits(const vec3 &rgb);
-    inline BasicSpectrum smits(Float r, Float g, Float b) { return smits({r, g, b}); }
+    /**
+     *  Writes SMITS_SPECTRUM_SIZE values for SMITS_WAVELENGHTS to dst.
+     */
+    void smits(const vec3 &rgb, Float *dst);
+
+    SampledSpectrum smits(const vec3 &rgb);
+    inline SampledSpectrum smits(Float r, Float g, Float b) { return smits({r, g, b}); }
 
 }
 
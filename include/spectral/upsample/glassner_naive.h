@@ -1,7 +1,7 @@
 #ifndef INCLUDE_SPECTRAL_UPSAMPLERS_GLASSNER_NAIVE_H
 #define INCLUDE_SPECTRAL_UPSAMPLERS_GLASSNER_NAIVE_H
 #include <spectral/upsample/upsampler.h>
-#include <spectral/spec/basic_spectrum.h>
+#include <spectral/spec/sampled_spectrum.h>
 
 namespace spec {
 
@@ -10,6 +10,10 @@ namespace spec {
     public:
         ISpectralImage::ptr upsample(const Image &sourceImage) const override;
         ISpectrum::ptr upsample_pixel(const Pixel &pixel) const override;
+        //batch output is GLASSNER_SPECTRUM_SIZE values at GLASSNER_WAVELENGHTS (in the same order)
+        unsigned get_batch_stride() const override;
+        void upsample_batch(const Pixel *src, size_t count, Float *dst) const override;
+        void upsample_batch(const vec3 *src, size_t count, Float *dst) const override;
         ~GlassnerUpsampler() = default;
     };
 }
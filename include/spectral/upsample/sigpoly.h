@@ -10,13 +10,17 @@ namespace spec {
     public:
         SigPolyUpsampler();
         SigPolyUpsampler(SigpolyLUT &&lut0, SigpolyLUT &&lut1, SigpolyLUT &&lut2)
-            : luts{std::move(lut0), std::move(lut1), std::move(lut2)} {}
+            : lut_set{std::move(lut0), std::move(lut1), std::move(lut2)} {}
 
         ISpectralImage::ptr upsample(const Image &sourceImage) const override;
         ISpectrum::ptr upsample_pixel(const Pixel &src) const override;
+        //batch output is 3 sigmoid polynomial coefficients
+        unsigned get_batch_stride() const override;
+        void upsample_batch(const Pixel *src, size_t count, Float *dst) const override;
+        void upsample_batch(const vec3 *src, size_t count, Float *dst) const override;
         ~SigPolyUpsampler() = default;
     private:
-        const SigpolyLUT luts[3];
+        const SigpolyLUTSet lut_set;
     };
 }
 
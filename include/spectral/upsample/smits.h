@@ -8,6 +8,10 @@ namespace spec {
     public:
         ISpectralImage::ptr upsample(const Image &sourceImage) const override;
         ISpectrum::ptr upsample_pixel(const Pixel &src) const override;
+        //batch output is SMITS_SPECTRUM_SIZE values at SMITS_WAVELENGHTS
+        unsigned get_batch_stride() const override;
+        void upsample_batch(const Pixel *src, size_t count, Float *dst) const override;
+        void upsample_batch(const vec3 *src, size_t count, Float *dst) const override;
         ~SmitsUpsampler() = default;
     };
 }
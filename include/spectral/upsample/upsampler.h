@@ -12,6 +12,19 @@ namespace spec {
         virtual ISpectralImage::ptr upsample(const Image &sourceImage) const = 0;
         virtual ISpectrum::ptr upsample_pixel(const Pixel &src) const = 0;
 
+        /**
+         *  Number of values written to destination buffer per pixel by upsample_batch.
+         * Their meaning depends on upsampler (samples at fixed wavelenghts or coefficients).
+         */
+        virtual unsigned get_batch_stride() const = 0;
+
+        /**
+         *  Upsamples count pixels and writes get_batch_stride() values per pixel to dst.
+         * Destination buffer must hold at least count * get_batch_stride() values.
+         */
+        virtual void upsample_batch(const Pixel *src, size_t count, Float *dst) const = 0;
+        virtual void upsample_batch(const vec3 *src, size_t count, Float *dst) const = 0;
+
         virtual ~IUpsampler() {}
 
         using ptr = std::unique_ptr<IUpsampler>;
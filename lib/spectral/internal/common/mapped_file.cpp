@@ -0,0 +1,64 @@
+#include <internal/common/mapped_file.h>
+#include <internal/common/format.h>
+#include <fstream>
+#include <stdexcept>
+
+#if defined(__unix__) || defined(__APPLE__)
+#define SPECTRAL_HAS_MMAP
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+namespace spec {
+
+    namespace {
+
+        std::vector<char> read_whole(const std::string &path)
+        {
+            std::ifstream file{path, std::ios::binary | std::ios::ate};
+            if(!file) throw std::runtime_error(format("Cannot open file %s", path.c_str()));
+            std::vector<char> data(file.tellg());
+            file.seekg(0);
+            file.read(data.data(), data.size());
+            if(!file) throw std::runtime_error(format("Cannot read file %s", path.c_str()));
+            return data;
+        }
+
+    }
+
+    MappedFile::MappedFile(const std::string &path) : begin{nullptr}, length{0}, mapped{false}, buffer{}
+    {
+#ifdef SPECTRAL_HAS_MMAP
+        const int fd = ::open(path.c_str(), O_RDONLY);
+        if(fd < 0) throw std::runtime_error(format("Cannot open file %s", path.c_str()));
+
+        struct stat st;
+        if(::fstat(fd, &st) == 0 && st.st_size > 0) {
+            void *addr = ::mmap(nullptr, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+            if(addr != MAP_FAILED) {
+                begin = static_cast<const char *>(addr);
+                length = st.st_size;
+                mapped = true;
+            }
+        }
+        ::close(fd);
+        if(mapped) return;
+#endif
+        //empty files and systems without mmap
+        buffer = read_whole(path);
+        begin = buffer.data();
+        length = buffer.size();
+    }
+
+    MappedFile::~MappedFile()
+    {
+#ifdef SPECTRAL_HAS_MMAP
+        if(mapped) {
+            ::munmap(const_cast<char *>(begin), length);
+        }
+#endif
+    }
+
+}
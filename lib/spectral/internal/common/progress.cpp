@@ -0,0 +1,91 @@
+#include <internal/common/progress.h>
+#include <iostream>
+#include <string>
+#include <cstdio>
+
+namespace spec {
+
+    namespace {
+
+        //check clock at most ~1000 times during operation
+        constexpr size_t COUNT_STEPS = 1000;
+
+        Progress::Callback &_default_callback()
+        {
+#ifndef SPECTRAL_DISABLE_PROGRESS_BAR
+            static Progress::Callback callback{Progress::console_callback};
+#else
+            static Progress::Callback callback{};
+#endif
+            return callback;
+        }
+
+    }
+
+    Progress::Progress(size_t total)
+        : Progress(total, get_default_callback()) {}
+
+    Progress::Progress(size_t total, Callback callback, std::chrono::milliseconds interval)
+        : total{total}, callback{std::move(callback)}, interval{interval}, start{Clock::now()},
+          count_step{total / COUNT_STEPS + 1}, done{0}, next_report{total / COUNT_STEPS + 1}, last_report{}, finished{false}, report_lock{} {}
+
+    void Progress::report(size_t val, bool force)
+    {
+        std::unique_lock<std::mutex> lock{report_lock, std::defer_lock};
+        if(force) {
+            lock.lock();
+        }
+        else if(!lock.try_lock()) {
+            //other thread is reporting right now
+            return;
+        }
+        if(finished) return;
+
+        const Clock::time_point now = Clock::now();
+        next_report.store(val + count_step, std::memory_order_relaxed);
+        if(!force && now - last_report < interval) return;
+        last_report = now;
+        finished = force;
+
+        const double elapsed = std::chrono::duration<double>(now - start).count();
+        const double rate = elapsed > 0.0 ? val / elapsed : 0.0;
+        const double eta = rate > 0.0 && total > val ? (total - val) / rate : 0.0;
+        callback(Info{val, total, elapsed, rate, eta, force});
+    }
+
+    void Progress::finish()
+    {
+        if(!callback) return;
+        report(done.load(std::memory_order_relaxed), true);
+    }
+
+    void Progress::set_default_callback(Callback callback)
+    {
+        _default_callback() = std::move(callback);
+    }
+
+    const Progress::Callback &Progress::get_default_callback()
+    {
+        return _default_callback();
+    }
+
+    void Progress::console_callback(const Info &info)
+    {
+        static const unsigned bar_length = 50;
+        const double part = info.total ? double(info.done) / info.total : 1.0;
+        const unsigned progress_points = bar_length * (part > 1.0 ? 1.0 : part);
+
+        char stats[96];
+        std::snprintf(stats, sizeof(stats), " - %u%%, %.0f/s, ETA %.1fs   ", unsigned(100.0 * part), info.rate, info.eta);
+
+        std::cout << "\r[" << std::string(progress_points, '*') << std::string(bar_length - progress_points, ' ')
+                  << "] " << info.done << "/" << info.total << stats;
+        if(info.finished) {
+            std::cout << std::endl;
+        }
+        else {
+            std::cout.flush();
+        }
+    }
+
+}
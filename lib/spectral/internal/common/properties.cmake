@@ -3,6 +3,8 @@ set(MODULE_PATH ${SRC}/spectral/common)
 
 set(MODULE_SOURCES
     util.cpp
+    progress.cpp
+    mapped_file.cpp
     refl.cpp
     constants.cpp
 )
@@ -1,52 +1,14 @@
 #include <internal/common/util.h>
-#include <iostream>
 #include <algorithm>
+#include <cinttypes>
+#include <cstring>
 
-namespace spec {
-#ifndef SPECTRAL_DISABLE_PROGRESS_BAR
-
-    unsigned _progress_max_count = 1;
-    unsigned _progress_min_update_step = 1;
-    unsigned _prev_val = 0;
-
-#endif
-
-    void init_progress_bar(unsigned maxcount, unsigned minupdate) {
-#ifndef SPECTRAL_DISABLE_PROGRESS_BAR
-
-        _progress_max_count = maxcount;
-        _progress_min_update_step = minupdate;
-        _prev_val = 0;
-        std::cout << std::endl;
-
-#else
-        (void) maxcount; (void) minupdate;
-#endif
-    }
-
-    void finish_progress_bar() {
-#ifndef SPECTRAL_DISABLE_PROGRESS_BAR
-        print_progress(_progress_max_count, true);
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define SPECTRAL_SWAP_SSSE3
+#include <immintrin.h>
 #endif
-    }
-
-    void print_progress(unsigned count, bool force) 
-    {
-#ifndef SPECTRAL_DISABLE_PROGRESS_BAR
-
-        static const unsigned bar_length = 100;
-        if(force || count - _prev_val > _progress_min_update_step) {
-            _prev_val = (count / _progress_min_update_step) * _progress_min_update_step;
-            unsigned progress_points = bar_length * (count / static_cast<float>(_progress_max_count));
-            std::cout << "\033[F[";
-            std::cout << std::string(progress_points, '*') + std::string(bar_length - progress_points, ' ');
-            std::cout << "] " << count << "/" << _progress_max_count << " - " << progress_points << "%\n";
-        }
 
-#else
-        (void) count; (void) force;
-#endif
-    }
+namespace spec {
 
     bool is_little_endian()
     {
@@ -75,4 +37,84 @@ namespace spec {
         convert_to_native_order(src, dst, size, to_big_endian);
     }
 
-}
\ No newline at end of file
+
+    namespace {
+
+        template<typename T, T (*swap)(T)>
+        void _swap_scalar(char *data, size_t count)
+        {
+            for(size_t i = 0; i < count; ++i) {
+                T val;
+                std::memcpy(&val, data + i * sizeof(T), sizeof(T));
+                val = swap(val);
+                std::memcpy(data + i * sizeof(T), &val, sizeof(T));
+            }
+        }
+
+        uint16_t _swap16(uint16_t v) { return __builtin_bswap16(v); }
+        uint32_t _swap32(uint32_t v) { return __builtin_bswap32(v); }
+        uint64_t _swap64(uint64_t v) { return __builtin_bswap64(v); }
+
+#ifdef SPECTRAL_SWAP_SSSE3
+        //swaps 16 bytes per iteration, returns number of processed values
+        __attribute__((target("ssse3")))
+        size_t _swap_ssse3(char *data, size_t count, unsigned size)
+        {
+            __m128i mask;
+            switch(size) {
+            case 2:
+                mask = _mm_setr_epi8(1, 0, 3, 2, 5, 4, 7, 6, 9, 8, 11, 10, 13, 12, 15, 14);
+                break;
+            case 4:
+                mask = _mm_setr_epi8(3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14, 13, 12);
+                break;
+            case 8:
+                mask = _mm_setr_epi8(7, 6, 5, 4, 3, 2, 1, 0, 15, 14, 13, 12, 11, 10, 9, 8);
+                break;
+            default:
+                return 0;
+            }
+
+            const size_t bytes = count * size / 16 * 16;
+            for(size_t i = 0; i < bytes; i += 16) {
+                __m128i *ptr = reinterpret_cast<__m128i *>(data + i);
+                _mm_storeu_si128(ptr, _mm_shuffle_epi8(_mm_loadu_si128(ptr), mask));
+            }
+            return bytes / size;
+        }
+#endif
+
+    }
+
+    void swap_bytes(char *data, size_t count, unsigned size)
+    {
+        if(size < 2) return;
+
+        size_t done = 0;
+#ifdef SPECTRAL_SWAP_SSSE3
+        static const bool has_ssse3 = __builtin_cpu_supports("ssse3");
+        if(has_ssse3) {
+            done = _swap_ssse3(data, count, size);
+        }
+#endif
+        data += done * size;
+        count -= done;
+
+        switch(size) {
+        case 2:
+            _swap_scalar<uint16_t, _swap16>(data, count);
+            break;
+        case 4:
+            _swap_scalar<uint32_t, _swap32>(data, count);
+            break;
+        case 8:
+            _swap_scalar<uint64_t, _swap64>(data, count);
+            break;
+        default:
+            for(size_t i = 0; i < count; ++i) {
+                std::reverse(data + i * size, data + (i + 1) * size);
+            }
+        }
+    }
+
+}
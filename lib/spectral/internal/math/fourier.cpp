@@ -1,9 +1,16 @@
 #include <internal/math/fourier.h>
 #include <internal/math/levinson.h>
+#include <algorithm>
 #include <cassert>
+#include <cstdint>
 
 #include <iostream>
 
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define SPECTRAL_FOURIER_AVX2
+#include <immintrin.h>
+#endif
+
 namespace spec::math {
 
     Float to_phase(Float wl, Float start, Float end)
@@ -45,7 +52,7 @@ namespace spec::math {
 
     namespace {
 
-        std::vector<Complex> exponential_moments(const std::vector<Float> moments, Complex &gamma0)
+        std::vector<Complex> exponential_moments(const std::vector<Float> &moments, Complex &gamma0)
         {
             gamma0 = 0.5f * INV_TWO_PI * std::exp(PI * I * (moments[0] - 0.5f));
             const int M = moments.size() - 1;
@@ -92,6 +99,131 @@ namespace spec::math {
         return levinson<Float>(data, e0);
     }
 
+    namespace {
+
+        void _precompute_mese_coeffs_scalar(const Float *gamma, size_t count, int M, Float *dst)
+        {
+            const int stride = M + 1;
+            std::vector<Float> data(2 * M + 1);
+            std::vector<Float> e0(stride, 0.0f);
+            e0[0] = 1.0f;
+
+            for(size_t p = 0; p < count; ++p) {
+                const Float *g = gamma + p * stride;
+                Float *q = dst + p * stride;
+                if(g[0] == 0.0f) {
+                    std::fill(q, q + stride, 0.0f);
+                    continue;
+                }
+                data[M] = INV_TWO_PI * g[0];
+                for(int i = 1; i <= M; ++i) {
+                    data[M + i] = INV_TWO_PI * g[i];
+                    data[M - i] = INV_TWO_PI * g[i];
+                }
+                levinson(data.data(), e0.data(), M, q);
+            }
+        }
+
+#ifdef SPECTRAL_FOURIER_AVX2
+        /**
+         *  Levinson recursion for 8 symmetric systems at once, one system per lane. Operations
+         * are the same as in levinson_inplace (without fma), so results match scalar code exactly.
+         */
+        __attribute__((target("avx2")))
+        void _precompute_mese_coeffs_avx2(const Float *gamma, size_t count, int M, Float *dst)
+        {
+            constexpr int LANES = 8;
+            const int stride = M + 1;
+            //r, fn, bn, x and transposition buffer, M + 1 vectors each
+            std::vector<Float> scratch(5 * stride * LANES + LANES);
+            const uintptr_t addr = reinterpret_cast<uintptr_t>(scratch.data());
+            __m256 *r = reinterpret_cast<__m256 *>((addr + 31) & ~uintptr_t(31));
+            __m256 *fn = r + stride;
+            __m256 *bn = fn + stride;
+            __m256 *x = bn + stride;
+            alignas(32) Float lanes[LANES];
+            Float *tr = reinterpret_cast<Float *>(x + stride);
+
+            const __m256 zero = _mm256_setzero_ps();
+            const __m256 one = _mm256_set1_ps(1.0f);
+            const __m256 sign = _mm256_set1_ps(-0.0f);
+            const __m256 inv_two_pi = _mm256_set1_ps(INV_TWO_PI);
+
+            const size_t vec_count = count - count % LANES;
+            for(size_t p = 0; p < vec_count; p += LANES) {
+                const Float *g = gamma + p * stride;
+                for(int k = 0; k <= M; ++k) {
+                    for(int l = 0; l < LANES; ++l) {
+                        tr[k * LANES + l] = g[l * stride + k];
+                    }
+                    r[k] = _mm256_mul_ps(inv_two_pi, _mm256_loadu_ps(tr + k * LANES));
+                }
+
+                const __m256 t = _mm256_div_ps(one, r[0]);
+                fn[0] = t;
+                bn[0] = t;
+                x[0] = t;
+
+                for(int i = 1; i <= M; ++i) {
+                    __m256 ef1 = zero;
+                    __m256 eb1 = zero;
+                    __m256 ex1 = zero;
+                    for(int j = 0; j < i; ++j) {
+                        ef1 = _mm256_add_ps(ef1, _mm256_mul_ps(r[i - j], fn[j]));
+                        ex1 = _mm256_add_ps(ex1, _mm256_mul_ps(r[i - j], x[j]));
+                        eb1 = _mm256_add_ps(eb1, _mm256_mul_ps(r[j + 1], bn[j]));
+                    }
+
+                    const __m256 div = _mm256_div_ps(one, _mm256_sub_ps(one, _mm256_mul_ps(ef1, eb1)));
+                    const __m256 ef_div = _mm256_mul_ps(ef1, div);
+                    const __m256 eb_div = _mm256_mul_ps(_mm256_xor_ps(eb1, sign), div);
+                    fn[i] = _mm256_sub_ps(zero, _mm256_mul_ps(ef_div, bn[i - 1]));
+                    bn[i] = _mm256_add_ps(zero, _mm256_mul_ps(div, bn[i - 1]));
+                    for(int j = i - 1; j > 0; --j) {
+                        const __m256 f = fn[j];
+                        fn[j] = _mm256_sub_ps(_mm256_mul_ps(div, f), _mm256_mul_ps(ef_div, bn[j - 1]));
+                        bn[j] = _mm256_add_ps(_mm256_mul_ps(eb_div, f), _mm256_mul_ps(div, bn[j - 1]));
+                    }
+                    bn[0] = _mm256_mul_ps(eb_div, fn[0]);
+                    fn[0] = _mm256_mul_ps(div, fn[0]);
+
+                    const __m256 mul = _mm256_sub_ps(zero, ex1);
+                    for(int j = 0; j < i; ++j) {
+                        x[j] = _mm256_add_ps(x[j], _mm256_mul_ps(mul, bn[j]));
+                    }
+                    x[i] = _mm256_mul_ps(mul, bn[i]);
+                }
+
+                Float *q = dst + p * stride;
+                for(int k = 0; k <= M; ++k) {
+                    _mm256_store_ps(lanes, x[k]);
+                    for(int l = 0; l < LANES; ++l) {
+                        q[l * stride + k] = lanes[l];
+                    }
+                }
+                for(int l = 0; l < LANES; ++l) {
+                    if(g[l * stride] == 0.0f) std::fill(q + l * stride, q + (l + 1) * stride, 0.0f);
+                }
+            }
+
+            _precompute_mese_coeffs_scalar(gamma + vec_count * stride, count - vec_count, M, dst + vec_count * stride);
+        }
+#endif
+
+    }
+
+    void precompute_mese_coeffs(const Float *gamma, size_t count, int M, Float *dst)
+    {
+#ifdef SPECTRAL_FOURIER_AVX2
+        static const bool has_avx2 = __builtin_cpu_supports("avx2");
+        if(has_avx2) {
+            _precompute_mese_coeffs_avx2(gamma, count, M, dst);
+            return;
+        }
+#endif
+        _precompute_mese_coeffs_scalar(gamma, count, M, dst);
+    }
+
     std::vector<Complex> lagrange_multipliers(const std::vector<Float> &moments)
     {      
         const int M = moments.size() - 1;
@@ -108,16 +240,21 @@ namespace spec::math {
         std::cout << std::endl;
        */
 
+        //inner sums depend only on k + i, so autocorrelation of q is computed once
+        std::vector<Complex> autocorr(M + 1);
+        for(int d = 0; d <= M; ++d) {
+            Complex ts{0.0f, 0.0f};
+            for(int j = 0; j <= M - d; ++j) {
+                ts += std::conj(q[j + d]) * q[j];
+            }
+            autocorr[d] = ts;
+        }
+
         std::vector<Complex> lambda(M + 1);
         for(int i = 0; i <= M; ++i) {
             Complex t{0.0f, 0.0f};
-
             for(int k = 0; k <= M - i; ++k) {
-                Complex ts{0.0f, 0.0f};
-                for(int j = 0; j <= M - k - i; ++j) {
-                    ts += std::conj(q[j + k + i]) * q[j];
-                }
-                t += ts * (k == 0 ? gamma0 : gamma[k]);
+                t += autocorr[k + i] * (k == 0 ? gamma0 : gamma[k]);
             }
             lambda[i] = t / (PI * I * q[0]);
         }
@@ -138,7 +275,11 @@ namespace spec::math {
 
     Float mese_precomp(Float phase, const std::vector<Float> &q)
     {
-        const int M = q.size() - 1;
+        return mese_precomp(phase, q.data(), q.size() - 1);
+    }
+
+    Float mese_precomp(Float phase, const Float *q, int M)
+    {
         Complex t = 0.0f;
         for(int i = 0; i <= M; ++i) t += INV_TWO_PI * q[i] * std::exp(-I * Float(i) * phase); 
 
@@ -148,4 +289,106 @@ namespace spec::math {
         return (INV_TWO_PI * std::real(q[0])) / div;
     }
 
-}
\ No newline at end of file
+
+    namespace {
+
+        //orders of LUTs in use are far below this
+        constexpr int CIE_GRID_MAX_M = 32;
+
+        constexpr size_t MESE_BLOCK = 64;
+
+    }
+
+    PhaseGrid::PhaseGrid(const std::vector<Float> &phases, int max_m)
+        : phases(phases), max_m(max_m), cos_table(phases.size() * (max_m + 1)), sin_table(phases.size() * (max_m + 1))
+    {
+        const size_t n = phases.size();
+        for(size_t j = 0; j < n; ++j) {
+            //angle addition in double, only one sin and cos per phase
+            const double c1 = std::cos(double(phases[j]));
+            const double s1 = std::sin(double(phases[j]));
+            double c = 1.0, s = 0.0;
+            for(int k = 0; k <= max_m; ++k) {
+                cos_table[k * n + j] = c;
+                sin_table[k * n + j] = s;
+                const double c_next = c * c1 - s * s1;
+                s = s * c1 + c * s1;
+                c = c_next;
+            }
+        }
+    }
+
+    void PhaseGrid::mese(const Float *q, int M, Float *dst) const
+    {
+        const size_t n = phases.size();
+        if(M > max_m) {
+            for(size_t j = 0; j < n; ++j) {
+                dst[j] = mese_precomp(phases[j], q, M);
+            }
+            return;
+        }
+
+        const Float q0 = INV_TWO_PI * q[0];
+        for(size_t start = 0; start < n; start += MESE_BLOCK) {
+            const size_t count = std::min(MESE_BLOCK, n - start);
+            Float re[MESE_BLOCK], im[MESE_BLOCK];
+            std::fill(re, re + count, q0);
+            std::fill(im, im + count, 0.0f);
+
+            for(int k = 1; k <= M; ++k) {
+                const Float qk = INV_TWO_PI * q[k];
+                const Float *c = cos_table.data() + k * n + start;
+                const Float *s = sin_table.data() + k * n + start;
+                for(size_t j = 0; j < count; ++j) {
+                    re[j] += qk * c[j];
+                    im[j] += qk * s[j];
+                }
+            }
+
+            for(size_t j = 0; j < count; ++j) {
+                dst[start + j] = q0 / (re[j] * re[j] + im[j] * im[j]);
+            }
+        }
+    }
+
+    void PhaseGrid::bounded_mese_l(const Complex *lagrange_m, int M, Float *dst) const
+    {
+        const size_t n = phases.size();
+        if(M > max_m) {
+            const std::vector<Complex> l(lagrange_m, lagrange_m + M + 1);
+            for(size_t j = 0; j < n; ++j) {
+                dst[j] = math::bounded_mese_l(phases[j], l);
+            }
+            return;
+        }
+
+        //real(l * e^(-ik phase)) = real(l) * cos(k phase) + imag(l) * sin(k phase)
+        std::fill(dst, dst + n, std::real(lagrange_m[0]));
+        for(int k = 1; k <= M; ++k) {
+            const Float re = 2.0f * std::real(lagrange_m[k]);
+            const Float im = 2.0f * std::imag(lagrange_m[k]);
+            const Float *c = cos_table.data() + k * n;
+            const Float *s = sin_table.data() + k * n;
+            for(size_t j = 0; j < n; ++j) {
+                dst[j] += re * c[j] + im * s[j];
+            }
+        }
+
+        for(size_t j = 0; j < n; ++j) {
+            dst[j] = INV_PI * std::atan(dst[j]) + 0.5f;
+        }
+    }
+
+    const PhaseGrid &cie_phase_grid()
+    {
+        static const PhaseGrid grid{[]() {
+            std::vector<Float> phases;
+            for(int lambda = WAVELENGHTS_START; lambda <= WAVELENGHTS_END; lambda += WAVELENGHTS_STEP) {
+                phases.push_back(to_phase(lambda));
+            }
+            return phases;
+        }(), CIE_GRID_MAX_M};
+        return grid;
+    }
+
+}
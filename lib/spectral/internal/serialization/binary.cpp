@@ -8,4 +8,7 @@ namespace spec::binary {
 
     template void write_vec(std::ostream &dst, const vec3 &val);
     template vec3 read_vec(std::istream &src);
+
+    template void read_array(std::istream &src, Float *dst, size_t count);
+    template void write_array(std::ostream &dst, const Float *src, size_t count);
 }
\ No newline at end of file
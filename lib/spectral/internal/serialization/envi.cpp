@@ -2,6 +2,7 @@
 #include <internal/serialization/parsers.h>
 #include <istream>
 #include <fstream>
+#include <limits>
 #include <algorithm>
 #include <cctype>
 #include <unordered_map>
@@ -242,13 +243,66 @@ out:
 
 
         if((it = entries.find("Illuminant")) != entries.end()) {
-            parse_simple_array<unsigned>(meta.illuminant, it->second, ';');
+            parse_simple_array<Float>(meta.illuminant, it->second, ';');
             entries.erase(it);
         }
         else {
             throw std::runtime_error("No Illuminant field found");
         }
 
+        if((it = entries.find("Illuminant wavelength")) != entries.end()) {
+            parse_simple_array<Float>(meta.illuminant_wavelength, it->second, ';');
+            entries.erase(it);
+        }
+        const size_t illuminant_size = meta.illuminant_wavelength.empty() ? meta.wavelength.size() : meta.illuminant_wavelength.size();
+        if(meta.illuminant.size() != illuminant_size) {
+            throw std::runtime_error("Number of illuminant values doesn't match its wavelenghts");
+        }
+
         return meta;
     }
-}
\ No newline at end of file
+
+    void MetaENVI::save(const std::string &path) const
+    {
+        std::ofstream file{path, std::ios::trunc};
+        if(!file) throw std::runtime_error("Cannot open file");
+        file.precision(std::numeric_limits<Float>::max_digits10);
+
+        file << "ENVI\n";
+        file << "file type = ENVI Standard\n";
+        file << "samples = " << samples << "\n";
+        file << "lines = " << lines << "\n";
+        file << "bands = " << bands << "\n";
+        file << "header offset = " << header_offset << "\n";
+        if(data_type != DataType::UNSUPPORTED) {
+            file << "data type = " << (data_type == DataType::FLOAT32 ? 4 : 5) << "\n";
+        }
+        file << "interleave = " << (interleave == Interleave::BSQ ? "bsq" : (interleave == Interleave::BIL ? "bil" : "bip")) << "\n";
+        file << "byte order = " << (byte_order == ByteOrder::LITTLE_ENDIAN_ORDER ? 0 : 1) << "\n";
+        if(wavelength_units == UnitType::NANOMETER) {
+            file << "wavelength units = Nanometers\n";
+        }
+
+        //blocks are closed by separator, see fill_entries
+        file << "wavelength = {";
+        for(Float w : wavelength) {
+            file << w << ",";
+        }
+        file << "}\n";
+
+        file << "Illuminant = {";
+        for(Float val : illuminant) {
+            file << val << ";";
+        }
+        file << "}\n";
+
+        if(!illuminant_wavelength.empty()) {
+            file << "Illuminant wavelength = {";
+            for(Float w : illuminant_wavelength) {
+                file << w << ";";
+            }
+            file << "}\n";
+        }
+    }
+
+}
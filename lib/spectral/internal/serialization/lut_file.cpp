@@ -0,0 +1,166 @@
+#include <internal/serialization/lut_file.h>
+#include <internal/common/util.h>
+#include <atomic>
+#include <cstring>
+#include <stdexcept>
+
+namespace spec::lut_file {
+
+    namespace {
+
+        constexpr uint64_t FNV_OFFSET = 0xcbf29ce484222325;
+        constexpr uint64_t FNV_PRIME = 0x100000001b3;
+
+#ifdef SPECTRAL_VERIFY_LUT_CHECKSUM
+        std::atomic<bool> verify_checksums{true};
+#else
+        std::atomic<bool> verify_checksums{false};
+#endif
+
+        void require_little_endian()
+        {
+            if(!is_little_endian()) throw std::runtime_error("LUT format v2 is supported only on little-endian hosts");
+        }
+
+        size_t align(size_t offset)
+        {
+            return (offset + ALIGNMENT - 1) / ALIGNMENT * ALIGNMENT;
+        }
+
+        void validate(const Header &header, uint64_t marker)
+        {
+            if(header.marker != marker || header.version != VERSION || header.float_size != sizeof(Float)) {
+                throw std::invalid_argument("Unsupported file");
+            }
+            if(header.step == 0 || header.payload_offset % ALIGNMENT != 0
+               || header.payload_offset < sizeof(Header) + uint64_t(header.power_count) * sizeof(Float)) {
+                throw std::invalid_argument("Damaged LUT header");
+            }
+        }
+
+    }
+
+    uint64_t checksum(const char *data, size_t size, uint64_t seed)
+    {
+        //FNV-1a over 64 bit words
+        uint64_t hash = seed;
+        size_t i = 0;
+        for(; i + sizeof(uint64_t) <= size; i += sizeof(uint64_t)) {
+            uint64_t word;
+            std::memcpy(&word, data + i, sizeof(uint64_t));
+            hash = (hash ^ word) * FNV_PRIME;
+        }
+        for(; i < size; ++i) {
+            hash = (hash ^ static_cast<uint8_t>(data[i])) * FNV_PRIME;
+        }
+        return hash;
+    }
+
+    uint64_t checksum(const Float *power_values, size_t power_count, const char *payload, size_t size)
+    {
+        const uint64_t seed = checksum(reinterpret_cast<const char *>(power_values), power_count * sizeof(Float), FNV_OFFSET);
+        return checksum(payload, size, seed);
+    }
+
+    void set_checksum_verification(bool enabled)
+    {
+        verify_checksums = enabled;
+    }
+
+    bool checksum_verification()
+    {
+        return verify_checksums;
+    }
+
+    void verify(const View &view)
+    {
+        if(checksum(view.power_values, view.header.power_count, view.payload, view.header.payload_size) != view.header.checksum) {
+            throw std::invalid_argument("LUT checksum mismatch");
+        }
+    }
+
+    bool is_v2(const char *data, size_t size, uint64_t marker)
+    {
+        if(size < sizeof(Header) || !is_little_endian()) return false;
+        uint64_t file_marker;
+        std::memcpy(&file_marker, data, sizeof(uint64_t));
+        return file_marker == marker;
+    }
+
+    bool is_v2(std::istream &src, uint64_t marker)
+    {
+        char buf[sizeof(uint64_t)];
+        const auto pos = src.tellg();
+        src.read(buf, sizeof(buf));
+        const bool res = src && is_v2(buf, sizeof(Header), marker);
+        src.clear();
+        src.seekg(pos);
+        return res;
+    }
+
+    View parse(const char *data, size_t size, uint64_t marker)
+    {
+        require_little_endian();
+        if(size < sizeof(Header)) throw std::invalid_argument("Unsupported file");
+
+        View view;
+        std::memcpy(&view.header, data, sizeof(Header));
+        validate(view.header, marker);
+        //power values end before payload_offset (see validate), written without sum so it can't overflow
+        if(view.header.payload_offset > size || view.header.payload_size > size - view.header.payload_offset) {
+            throw std::invalid_argument("LUT file is truncated");
+        }
+
+        view.power_values = reinterpret_cast<const Float *>(data + sizeof(Header));
+        view.payload = data + view.header.payload_offset;
+
+        if(verify_checksums) verify(view);
+        return view;
+    }
+
+    Header read_header(std::istream &src, uint64_t marker, std::vector<Float> &power_values)
+    {
+        require_little_endian();
+        Header header;
+        src.read(reinterpret_cast<char *>(&header), sizeof(Header));
+        if(!src) throw std::invalid_argument("Unsupported file");
+        validate(header, marker);
+
+        power_values.resize(header.power_count);
+        src.read(reinterpret_cast<char *>(power_values.data()), power_values.size() * sizeof(Float));
+        src.ignore(header.payload_offset - sizeof(Header) - power_values.size() * sizeof(Float));
+        if(!src) throw std::invalid_argument("LUT file is truncated");
+        return header;
+    }
+
+    void read_payload(std::istream &src, const Header &header, const std::vector<Float> &power_values, char *dst)
+    {
+        src.read(dst, header.payload_size);
+        if(!src) throw std::invalid_argument("LUT file is truncated");
+        if(verify_checksums && checksum(power_values.data(), power_values.size(), dst, header.payload_size) != header.checksum) {
+            throw std::invalid_argument("LUT checksum mismatch");
+        }
+    }
+
+    void write(std::ostream &dst, uint64_t marker, unsigned step, unsigned m, const std::vector<Float> &power_values, const char *payload, size_t size)
+    {
+        require_little_endian();
+        Header header{};
+        header.marker = marker;
+        header.version = VERSION;
+        header.float_size = sizeof(Float);
+        header.step = step;
+        header.m = m;
+        header.power_count = power_values.size();
+        header.payload_offset = align(sizeof(Header) + power_values.size() * sizeof(Float));
+        header.payload_size = size;
+        header.checksum = checksum(power_values.data(), power_values.size(), payload, size);
+
+        const std::vector<char> padding(header.payload_offset - sizeof(Header) - power_values.size() * sizeof(Float), 0);
+        dst.write(reinterpret_cast<const char *>(&header), sizeof(Header));
+        dst.write(reinterpret_cast<const char *>(power_values.data()), power_values.size() * sizeof(Float));
+        dst.write(padding.data(), padding.size());
+        dst.write(payload, size);
+    }
+
+}
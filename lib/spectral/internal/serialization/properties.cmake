@@ -4,6 +4,7 @@ set(MODULE_PATH ${SRC}/spectral/serialization)
 set(MODULE_SOURCES
     parsers.cpp
     binary.cpp
+    lut_file.cpp
     envi.cpp
 )
 
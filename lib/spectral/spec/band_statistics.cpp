@@ -0,0 +1,39 @@
+#include <spec/band_statistics.h>
+#include <algorithm>
+#include <limits>
+#include <stdexcept>
+
+namespace spec {
+
+    BandStatistics::BandStatistics(std::vector<Float> wl)
+        : wavelenghts(std::move(wl)), min(wavelenghts.size(), std::numeric_limits<Float>::max()),
+          max(wavelenghts.size(), std::numeric_limits<Float>::lowest()), mean(wavelenghts.size(), 0.0f),
+          sum(wavelenghts.size(), 0.0), count(wavelenghts.size(), 0) {}
+
+    int BandStatistics::find_band(Float w) const
+    {
+        auto it = std::lower_bound(wavelenghts.begin(), wavelenghts.end(), w);
+        if(it == wavelenghts.end() || *it != w) return -1;
+        return it - wavelenghts.begin();
+    }
+
+    void BandStatistics::merge(const BandStatistics &other)
+    {
+        if(other.wavelenghts != wavelenghts) throw std::invalid_argument("Statistics have different bands");
+
+        for(size_t b = 0; b < wavelenghts.size(); ++b) {
+            min[b] = std::min(min[b], other.min[b]);
+            max[b] = std::max(max[b], other.max[b]);
+            sum[b] += other.sum[b];
+            count[b] += other.count[b];
+        }
+    }
+
+    void BandStatistics::finish()
+    {
+        for(size_t b = 0; b < wavelenghts.size(); ++b) {
+            mean[b] = count[b] ? Float(sum[b] / count[b]) : 0.0f;
+        }
+    }
+
+}
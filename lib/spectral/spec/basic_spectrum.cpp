@@ -8,6 +8,8 @@
 #include <fstream>
 #include <iostream>
 #include <algorithm>
+#include <cmath>
+#include <iterator>
 #include <unordered_map>
 #include <iostream>
 
@@ -19,36 +21,77 @@ namespace spec {
 
     const BasicSpectrum BasicSpectrum::none{};
 
+    namespace {
+
+        /**
+         *  Same rules as BasicSpectrum::get_or_interpolate. Iterator over wavelenghts walks along
+         * while wavelenghts are ascending and values are looked up only when it moves to the next interval.
+         */
+        template<typename WlFn>
+        void _sample_sorted(const std::set<Float> &wavelenghts, const std::unordered_map<Float, Float> &values, WlFn wl, size_t n, Float *out)
+        {
+            auto it = wavelenghts.begin();
+            auto cached = wavelenghts.end(); //interval which ends at cached has values f_a and f_b
+            Float f_a = 0.0f, f_b = 0.0f;
+            Float prev_w = 0.0f;
+            for(size_t i = 0; i < n; ++i) {
+                const Float w = wl(i);
+                if(i > 0 && w < prev_w) {
+                    it = wavelenghts.lower_bound(w);
+                }
+                else {
+                    while(it != wavelenghts.end() && *it < w) ++it;
+                }
+                prev_w = w;
+
+                if(it == wavelenghts.end()) {
+                    out[i] = 0.0f;
+                    continue;
+                }
+                if(it != cached) {
+                    const bool next = cached != wavelenghts.end() && std::next(cached) == it;
+                    f_a = next ? f_b : (it != wavelenghts.begin() ? values.at(*std::prev(it)) : 0.0f);
+                    f_b = values.at(*it);
+                    cached = it;
+                }
+
+                if(*it == w) {
+                    out[i] = f_b;
+                }
+                else if(it == wavelenghts.begin()) {
+                    out[i] = 0.0f;
+                }
+                else {
+                    out[i] = math::interpolate(w, *std::prev(it), *it, f_a, f_b);
+                }
+            }
+        }
+
+    }
+
     const ISpectrum &ISpectrum::none()
     {
         return BasicSpectrum::none;
     }
 
-    void BasicSpectrum::set(Float wavelenght, Float value)
+    BasicSpectrum::BasicSpectrum(std::initializer_list<std::pair<const Float, Float>> l)
+        : spectre(l)
     {
-        modified = true;
-        //std::cout << wavelenght << " " << value << std::endl;
-        spectre[wavelenght] = value;
+        for(const auto &p : spectre) {
+            wavelenghts.insert(p.first);
+        }
     }
 
-    const std::set<Float> &BasicSpectrum::get_wavelenghts() const
+    void BasicSpectrum::set(Float wavelenght, Float value)
     {
-        #pragma omp critical
-        {
-            if(modified) {
-                cached_wavelenghts.clear();
-                for(const auto &p : spectre) {
-                    cached_wavelenghts.insert(p.first);
-                }
-                modified = false;
-            }
-        }
-        return cached_wavelenghts;
+        //std::cout << wavelenght << " " << value << std::endl;
+        spectre[wavelenght] = value;
+        wavelenghts.insert(wavelenght);
     }
 
     Float &BasicSpectrum::operator[](Float w)
     {
-        modified = true;
+        //only existing samples are accessible, so wavelenghts do not change
         return spectre.at(w);
     }
 
@@ -59,14 +102,12 @@ namespace spec {
 
     Float &BasicSpectrum::get_or_create(Float w)
     {
-        modified = true;
+        wavelenghts.insert(w);
         return spectre[w];
     }
 
     Float BasicSpectrum::get_or_interpolate(Float w) const
     {   
-        const std::set<Float> &wavelenghts = get_wavelenghts();
-
         auto it = wavelenghts.lower_bound(w);
 
         if(it == wavelenghts.end()) {
@@ -88,11 +129,20 @@ namespace spec {
         return math::interpolate(w, a, b, f_a, f_b);
     }
 
+    void BasicSpectrum::sample_into(const Float *wavelenghts, size_t n, Float *out) const
+    {
+        _sample_sorted(this->wavelenghts, spectre, [wavelenghts](size_t i) { return wavelenghts[i]; }, n, out);
+    }
+
+    void BasicSpectrum::sample_into(Float start, Float step, size_t n, Float *out) const
+    {
+        _sample_sorted(wavelenghts, spectre, [start, step](size_t i) { return start + i * step; }, n, out);
+    }
+
     BasicSpectrum &BasicSpectrum::operator=(BasicSpectrum &&other)
     {
         if(this != &other) { 
-            cached_wavelenghts = std::move(other.cached_wavelenghts);
-            modified = std::move(other.modified);
+            wavelenghts = std::move(other.wavelenghts);
             spectre = std::move(other.spectre);
         }
         return *this;
@@ -159,6 +209,64 @@ namespace spec {
             }
         }
 
+        BandStatistics::ptr _compute_statistics(const BasicSpectralImage &img)
+        {
+            //wavelenghts of image are expected in every pixel, any other are collected separately
+            const std::vector<Float> known(img.get_wavelenghts().begin(), img.get_wavelenghts().end());
+            const long size = long(img.get_width()) * img.get_height();
+            const BasicSpectrum *data = img.raw_data();
+
+            BandStatistics known_stats{known};
+            std::vector<std::pair<Float, Float>> other;
+
+            #pragma omp parallel
+            {
+                BandStatistics partial{known};
+                std::vector<std::pair<Float, Float>> partial_other;
+
+                #pragma omp for schedule(static)
+                for(long i = 0; i < size; ++i) {
+                    //iterate over map, so no lookups are needed
+                    for(const auto &[w, val] : data[i].get_map()) {
+                        const int b = partial.find_band(w);
+                        if(b >= 0) partial.add(b, val);
+                        else if(!std::isnan(val)) partial_other.emplace_back(w, val);
+                    }
+                }
+
+                #pragma omp critical(band_statistics_merge)
+                {
+                    known_stats.merge(partial);
+                    other.insert(other.end(), partial_other.begin(), partial_other.end());
+                }
+            }
+
+            std::vector<Float> wavelenghts;
+            for(size_t b = 0; b < known.size(); ++b) {
+                if(known_stats.count[b]) wavelenghts.push_back(known[b]);
+            }
+            for(const auto &p : other) {
+                wavelenghts.push_back(p.first);
+            }
+            std::sort(wavelenghts.begin(), wavelenghts.end());
+            wavelenghts.erase(std::unique(wavelenghts.begin(), wavelenghts.end()), wavelenghts.end());
+
+            auto stats = std::make_shared<BandStatistics>(std::move(wavelenghts));
+            for(size_t b = 0; b < known.size(); ++b) {
+                if(!known_stats.count[b]) continue;
+                const int id = stats->find_band(known[b]);
+                stats->min[id] = known_stats.min[b];
+                stats->max[id] = known_stats.max[b];
+                stats->sum[id] = known_stats.sum[b];
+                stats->count[id] = known_stats.count[b];
+            }
+            for(const auto &[w, val] : other) {
+                stats->add(stats->find_band(w), val);
+            }
+            stats->finish();
+            return stats;
+        }
+
     }
 
     /*
@@ -174,6 +282,7 @@ namespace spec {
         if(this != &other) { 
             SpectralImage<BasicSpectrum>::operator=(std::move(other));
             wavelenghts = std::move(other.wavelenghts);
+            statistics = std::move(other.statistics);
         }
         return *this;
     }
@@ -192,6 +301,16 @@ namespace spec {
             bool exists;
             filecheck(path, is_directory, exists);
 
+            MetaENVI::Interleave interleave;
+            MetaENVI::ByteOrder byte_order;
+            if(util::parse_envi_format(format.empty() && fs::path(path).extension() == ".hdr" ? "envi" : format, interleave, byte_order)) {
+                try {
+                    return util::save_envi_hdr(*this, path, fs::path(path).replace_extension("raw").string(), interleave, byte_order);
+                } catch (std::runtime_error &) {
+                    return false;
+                }
+            }
+
             SaveFormat type = get_type(path, format);
             std::cerr << type << std::endl;
 
@@ -236,13 +355,20 @@ namespace spec {
 
     bool BasicSpectralImage::validate() const
     {
-        std::set<Float> all_wavelenghts;
-        for(long i = 0; i < this->width * this->height; ++i) {
-            const auto &wl = this->data[i].get_wavelenghts();
-            all_wavelenghts.insert(wl.begin(), wl.end());
-        }
+        const BandStatistics::ptr stats = get_band_statistics();
         return std::includes(wavelenghts.begin(), wavelenghts.end(),
-                             all_wavelenghts.begin(), all_wavelenghts.end());
+                             stats->wavelenghts.begin(), stats->wavelenghts.end());
+    }
+
+    BandStatistics::ptr BasicSpectralImage::get_band_statistics() const
+    {
+        BandStatistics::ptr result;
+        #pragma omp critical(band_statistics)
+        {
+            if(!statistics) statistics = _compute_statistics(*this);
+            result = statistics;
+        }
+        return result;
     }
 
 
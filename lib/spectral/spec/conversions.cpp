@@ -1,17 +1,36 @@
 #include <spec/conversions.h> 
 #include <spec/spectral_util.h>
+#include <spec/dense_spectral_image.h>
+#include <spec/fourier_spectrum.h>
 #include <internal/common/lazy_value.h>
 #include <memory>
+#include <vector>
+#include <algorithm>
 #ifdef SPECTRAL_ENABLE_OPENMP
 #include <omp.h>
 #endif
 
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define SPECTRAL_CONVERSIONS_AVX2
+#include <immintrin.h>
+#endif
+
 #include <iostream>
 namespace spec {
     namespace {
 
         const vec3 D6500_WHITE_POINT{95.0489f, 100.0f, 108.8840f};
 
+        constexpr unsigned CIE_SAMPLES = (WAVELENGHTS_END - WAVELENGHTS_START) / WAVELENGHTS_STEP + 1;
+
+        /**
+         *  Writes values of spectrum at all CIE wavelenghts to dst.
+         */
+        void _sample_cie(const ISpectrum &spectrum, Float *dst)
+        {
+            spectrum.sample_into(WAVELENGHTS_START, WAVELENGHTS_STEP, CIE_SAMPLES, dst);
+        }
+
         Float _xyz2cielab_f(Float t)
         {
             static constexpr Float delta = 6.0f / 29.0f;
@@ -21,53 +40,247 @@ namespace spec {
 
             return t > delta3 ? std::cbrt(t) : (t / delta_div + f_tn);
         }
+
+        /**
+         *  Spectrum of a dense image is linear in its band values, so interpolation and
+         * integration with CMFs and light can be folded into 3 weights per band.
+         */
+        std::vector<vec3> dense_band_weights(const std::vector<Float> &wavelenghts, const std::vector<vec3> &cmf_weights)
+        {
+            std::vector<vec3> weights(wavelenghts.size());
+
+            unsigned idx = 0u;
+            for(int lambda = WAVELENGHTS_START; lambda <= WAVELENGHTS_END; lambda += WAVELENGHTS_STEP, ++idx) {
+                auto it = std::lower_bound(wavelenghts.begin(), wavelenghts.end(), Float(lambda));
+                if(it == wavelenghts.end()) continue;
+
+                const vec3 &cmf = cmf_weights[idx];
+                const unsigned b = it - wavelenghts.begin();
+                if(*it == lambda) {
+                    weights[b] += cmf;
+                }
+                else if(b != 0) {
+                    const Float t = (lambda - wavelenghts[b - 1]) / (wavelenghts[b] - wavelenghts[b - 1]);
+                    weights[b - 1] += cmf * (1.0f - t);
+                    weights[b] += cmf * t;
+                }
+            }
+            return weights;
+        }
+
+        Image dense_image2rgb(const DenseSpectralImage &img, const std::vector<vec3> &cmf_weights)
+        {
+            Image image{img.get_width(), img.get_height()};
+            const long size = long(img.get_width()) * img.get_height();
+            const int bands = img.get_bands();
+            const std::vector<vec3> weights = dense_band_weights(img.get_wavelenghts(), cmf_weights);
+            const Float *data = img.raw_data();
+            Pixel *out = image.raw_data();
+
+            if(img.get_layout() == DenseSpectralImage::Layout::PIXEL_INTERLEAVED) {
+                #pragma omp parallel for
+                for(long i = 0; i < size; ++i) {
+                    const Float *values = data + i * bands;
+                    vec3 xyz{0.0f, 0.0f, 0.0f};
+                    for(int b = 0; b < bands; ++b) {
+                        xyz += weights[b] * values[b];
+                    }
+                    out[i] = Pixel::from_vec3(xyz2rgb(xyz));
+                }
+            }
+            else {
+                std::vector<vec3> xyz(size, vec3{0.0f, 0.0f, 0.0f});
+                for(int b = 0; b < bands; ++b) {
+                    const Float *band = data + b * size;
+                    const vec3 w = weights[b];
+                    #pragma omp parallel for
+                    for(long i = 0; i < size; ++i) {
+                        xyz[i] += w * band[i];
+                    }
+                }
+                #pragma omp parallel for
+                for(long i = 0; i < size; ++i) {
+                    out[i] = Pixel::from_vec3(xyz2rgb(xyz[i]));
+                }
+            }
+            return image;
+        }
+
+        //polynomial values beyond this give sigmoid equal to 0 or 1 in single precision
+        constexpr Float SIGPOLY_LIMIT = 1e18f;
+
+        const Float *_cie_wavelenghts()
+        {
+            static const std::vector<Float> wavelenghts = [] {
+                std::vector<Float> wl(CIE_SAMPLES);
+                for(unsigned idx = 0; idx < CIE_SAMPLES; ++idx) {
+                    wl[idx] = WAVELENGHTS_START + Float(idx * WAVELENGHTS_STEP);
+                }
+                return wl;
+            }();
+            return wavelenghts.data();
+        }
+
+        void _sigpoly2xyz_scalar(const SigPolySpectrum *src, size_t count, vec3 *dst, const vec3 *weights)
+        {
+            const Float *wl = _cie_wavelenghts();
+            for(size_t i = 0; i < count; ++i) {
+                const vec3 &c = src[i].get();
+                vec3 xyz{0.0f, 0.0f, 0.0f};
+                for(unsigned idx = 0; idx < CIE_SAMPLES; ++idx) {
+                    const Float x = math::clamp(std::fma(std::fma(c.x, wl[idx], c.y), wl[idx], c.z), -SIGPOLY_LIMIT, SIGPOLY_LIMIT);
+                    xyz += weights[idx] * std::fma(0.5f, x / std::sqrt(std::fma(x, x, 1.0f)), 0.5f);
+                }
+                dst[i] = xyz;
+            }
+        }
+
+#ifdef SPECTRAL_CONVERSIONS_AVX2
+        /**
+         *  Evaluates 8 pixels per vector, one wavelenght per iteration, and accumulates XYZ in registers.
+         * Last vector is padded with zero polynomials and its extra lanes are dropped.
+         */
+        __attribute__((target("avx2,fma")))
+        void _sigpoly2xyz_avx2(const SigPolySpectrum *src, size_t count, vec3 *dst, const vec3 *weights)
+        {
+            constexpr int LANES = 8;
+            alignas(32) Float coef[3][LANES];
+            alignas(32) Float out[3][LANES];
+
+            const Float *wl = _cie_wavelenghts();
+            const __m256 half = _mm256_set1_ps(0.5f);
+            const __m256 one = _mm256_set1_ps(1.0f);
+            const __m256 hi = _mm256_set1_ps(SIGPOLY_LIMIT);
+            const __m256 lo = _mm256_set1_ps(-SIGPOLY_LIMIT);
+
+            for(size_t i = 0; i < count; i += LANES) {
+                const int lanes = count - i < size_t(LANES) ? count - i : LANES;
+                for(int k = 0; k < LANES; ++k) {
+                    const vec3 c = k < lanes ? src[i + k].get() : vec3{0.0f, 0.0f, 0.0f};
+                    coef[0][k] = c.x;
+                    coef[1][k] = c.y;
+                    coef[2][k] = c.z;
+                }
+                const __m256 c0 = _mm256_load_ps(coef[0]);
+                const __m256 c1 = _mm256_load_ps(coef[1]);
+                const __m256 c2 = _mm256_load_ps(coef[2]);
+
+                __m256 x_acc = _mm256_setzero_ps();
+                __m256 y_acc = _mm256_setzero_ps();
+                __m256 z_acc = _mm256_setzero_ps();
+                for(unsigned idx = 0; idx < CIE_SAMPLES; ++idx) {
+                    const __m256 w = _mm256_broadcast_ss(wl + idx);
+                    __m256 x = _mm256_fmadd_ps(_mm256_fmadd_ps(c0, w, c1), w, c2);
+                    x = _mm256_max_ps(_mm256_min_ps(x, hi), lo);
+                    const __m256 s = _mm256_div_ps(x, _mm256_sqrt_ps(_mm256_fmadd_ps(x, x, one)));
+                    const __m256 v = _mm256_fmadd_ps(half, s, half);
+
+                    x_acc = _mm256_fmadd_ps(_mm256_broadcast_ss(&weights[idx].x), v, x_acc);
+                    y_acc = _mm256_fmadd_ps(_mm256_broadcast_ss(&weights[idx].y), v, y_acc);
+                    z_acc = _mm256_fmadd_ps(_mm256_broadcast_ss(&weights[idx].z), v, z_acc);
+                }
+                _mm256_store_ps(out[0], x_acc);
+                _mm256_store_ps(out[1], y_acc);
+                _mm256_store_ps(out[2], z_acc);
+
+                for(int k = 0; k < lanes; ++k) {
+                    dst[i + k] = {out[0][k], out[1][k], out[2][k]};
+                }
+            }
+        }
+#endif
+
+        void _sigpoly2xyz(const SigPolySpectrum *src, size_t count, vec3 *dst, const vec3 *weights)
+        {
+#ifdef SPECTRAL_CONVERSIONS_AVX2
+            static const bool has_avx2 = __builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma");
+            if(has_avx2) {
+                _sigpoly2xyz_avx2(src, count, dst, weights);
+                return;
+            }
+#endif
+            _sigpoly2xyz_scalar(src, count, dst, weights);
+        }
+
+        Image sigpoly_image2rgb(const SigPolySpectralImage &img, const std::vector<vec3> &cmf_weights)
+        {
+            constexpr long CHUNK = 256;
+
+            Image image{img.get_width(), img.get_height()};
+            const long size = long(img.get_width()) * img.get_height();
+            const SigPolySpectrum *data = img.raw_data();
+            Pixel *out = image.raw_data();
+
+            #pragma omp parallel for
+            for(long start = 0; start < size; start += CHUNK) {
+                vec3 xyz[CHUNK];
+                const long count = std::min(CHUNK, size - start);
+                _sigpoly2xyz(data + start, count, xyz, cmf_weights.data());
+                for(long i = 0; i < count; ++i) {
+                    out[start + i] = Pixel::from_vec3(xyz2rgb(xyz[i]));
+                }
+            }
+            return image;
+        }
     }
 
     vec3 spectre2xyz(const ISpectrum &spectrum, const ISpectrum &light)
     {   
-        Float cieyint = &light == &util::CIE_D6500 ? util::get_cie_y_integral() : util::get_cie_y_integral(light);
-        vec3 xyz{0.0f, 0.0f, 0.0f};
+        return spectre2xyz(spectrum, *util::compute_cmf_weights(light));
+    }
 
-        unsigned idx = 0u;
-        for(int lambda = WAVELENGHTS_START; lambda <= WAVELENGHTS_END; lambda += WAVELENGHTS_STEP) {
-            const Float val_lv = spectrum(lambda) * light.get_or_interpolate(lambda);
-            
-            xyz.x += X_CURVE[idx] * val_lv;
-            xyz.y += Y_CURVE[idx] * val_lv;
-            xyz.z += Z_CURVE[idx] * val_lv;
-            idx += 1;
+    vec3 spectre2xyz(const ISpectrum &spectrum, const std::vector<vec3> &weights)
+    {
+        Float values[CIE_SAMPLES];
+        _sample_cie(spectrum, values);
+
+        vec3 xyz{0.0f, 0.0f, 0.0f};
+        for(unsigned idx = 0; idx < CIE_SAMPLES; ++idx) {
+            xyz += weights[idx] * values[idx];
         }
-        xyz /= cieyint;
         return xyz;
     }
 
     vec3 spectre2xyz0(const ISpectrum &spectrum)
     {
         vec3 xyz{0.0f, 0.0f, 0.0f};
+        Float values[CIE_SAMPLES];
+        _sample_cie(spectrum, values);
 
-        unsigned idx = 0u;
-        for(int lambda = WAVELENGHTS_START; lambda <= WAVELENGHTS_END; lambda += WAVELENGHTS_STEP) {
-            const Float val_lv = spectrum(lambda);
+        for(unsigned idx = 0; idx < CIE_SAMPLES; ++idx) {
+            const Float val_lv = values[idx];
             
             xyz.x += X_CURVE[idx] * val_lv;
             xyz.y += Y_CURVE[idx] * val_lv;
             xyz.z += Z_CURVE[idx] * val_lv;
-            idx += 1;
         }
         return xyz;
     }
 
     Image spectral_image2rgb(const ISpectralImage &img, const ISpectrum &light)
     {
+        return spectral_image2rgb(img, *util::compute_cmf_weights(light));
+    }
+
+    Image spectral_image2rgb(const ISpectralImage &img, const std::vector<vec3> &cmf_weights)
+    {
+        if(isa<DenseSpectralImage>(img)) {
+            return dense_image2rgb(static_cast<const DenseSpectralImage &>(img), cmf_weights);
+        }
+        if(isa<SigPolySpectralImage>(img)) {
+            return sigpoly_image2rgb(static_cast<const SigPolySpectralImage &>(img), cmf_weights);
+        }
+
+        require_precomputed(img);
+
         Image image{img.get_width(), img.get_height()};
-        const unsigned w = img.get_width();
-        const unsigned h = img.get_height();
-        vec3 rgb;
-
-     //   #pragma omp parallel for private(rgb) shared(image, img)
-        for(unsigned j = 0; j < h; ++j) {
-            for(unsigned i = 0; i < w; ++i) {
-                rgb = spectre2rgb(img.at(i, j), light);
+        const int w = img.get_width();
+        const int h = img.get_height();
+
+        #pragma omp parallel for shared(image, img)
+        for(int j = 0; j < h; ++j) {
+            for(int i = 0; i < w; ++i) {
+                const vec3 rgb = xyz2rgb(spectre2xyz(img.at(i, j), cmf_weights));
                 image.at(i, j) = Pixel::from_vec3(rgb);
             }
         }
@@ -90,21 +303,26 @@ namespace spec {
 
     vec3 sigpoly2xyz(Float a1, Float a2, Float a3)
     {
+        const util::CMFWeights weights = util::compute_cmf_weights(util::CIE_D6500);
         vec3 xyz{0.0f, 0.0f, 0.0f};
         const Float coef[3]{a1, a2, a3};
         unsigned idx = 0u;
-        for(int lambda = WAVELENGHTS_START; lambda <= WAVELENGHTS_END; lambda += WAVELENGHTS_STEP) {
-            const Float val_lv = math::sigmoid_polynomial(lambda, coef) * util::CIE_D6500.get_or_interpolate(lambda);
-            
-            xyz.x += X_CURVE[idx] * val_lv;
-            xyz.y += Y_CURVE[idx] * val_lv;
-            xyz.z += Z_CURVE[idx] * val_lv;
-            idx += 1;
+        for(int lambda = WAVELENGHTS_START; lambda <= WAVELENGHTS_END; lambda += WAVELENGHTS_STEP, ++idx) {
+            xyz += (*weights)[idx] * math::sigmoid_polynomial(lambda, coef);
         }
-        xyz /= util::get_cie_y_integral();
         return xyz;
     }
 
+    void sigpoly2xyz(const SigPolySpectrum *src, size_t count, vec3 *dst, const ISpectrum &light)
+    {
+        _sigpoly2xyz(src, count, dst, util::compute_cmf_weights(light)->data());
+    }
+
+    void sigpoly2xyz(const SigPolySpectrum *src, size_t count, vec3 *dst, const std::vector<vec3> &cmf_weights)
+    {
+        _sigpoly2xyz(src, count, dst, cmf_weights.data());
+    }
+
     std::pair<Float, Float> color2ior(Float r, Float g)
     {
         r = math::clamp(r, 0.0f, 0.9999999f);
@@ -0,0 +1,194 @@
+#include <spec/dense_spectral_image.h>
+#include <internal/math/math.h>
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+
+namespace spec {
+
+    template class PixelSpectrum<DenseSpectralImage>;
+
+    namespace {
+
+        std::vector<Float> sorted_unique(std::vector<Float> wl)
+        {
+            std::sort(wl.begin(), wl.end());
+            wl.erase(std::unique(wl.begin(), wl.end()), wl.end());
+            return wl;
+        }
+
+        BandStatistics::ptr _compute_statistics(const DenseSpectralImage &img)
+        {
+            auto stats = std::make_shared<BandStatistics>(img.get_wavelenghts());
+            const long size = long(img.get_width()) * img.get_height();
+            const int bands = img.get_bands();
+            const Float *data = img.raw_data();
+
+            if(img.get_band_stride() == 1) {
+                //pixels are contiguous, each thread sweeps its part of image over all bands
+                #pragma omp parallel
+                {
+                    BandStatistics partial{img.get_wavelenghts()};
+
+                    #pragma omp for schedule(static)
+                    for(long i = 0; i < size; ++i) {
+                        const Float *pixel = data + i * img.get_pixel_stride();
+                        for(int b = 0; b < bands; ++b) {
+                            partial.add(b, pixel[b]);
+                        }
+                    }
+
+                    #pragma omp critical(band_statistics_merge)
+                    stats->merge(partial);
+                }
+            }
+            else {
+                const long pixel_stride = img.get_pixel_stride();
+
+                #pragma omp parallel for schedule(dynamic)
+                for(int b = 0; b < bands; ++b) {
+                    const Float *band = data + b * img.get_band_stride();
+                    Float min_val = stats->min[b];
+                    Float max_val = stats->max[b];
+                    double sum = 0.0;
+                    long count = 0;
+                    for(long i = 0; i < size; ++i) {
+                        const Float val = band[i * pixel_stride];
+                        if(std::isnan(val)) continue;
+                        min_val = val < min_val ? val : min_val;
+                        max_val = val > max_val ? val : max_val;
+                        sum += val;
+                        ++count;
+                    }
+                    stats->min[b] = min_val;
+                    stats->max[b] = max_val;
+                    stats->sum[b] = sum;
+                    stats->count[b] = count;
+                }
+            }
+
+            stats->finish();
+            return stats;
+        }
+
+    }
+
+    DenseSpectralImage::DenseSpectralImage()
+        : ISpectralImage(0, 0), wavelenghts(), layout(Layout::PIXEL_INTERLEAVED), pixel_stride(0), band_stride(0), data(), spectra(), statistics() {}
+
+    DenseSpectralImage::DenseSpectralImage(int w, int h, const std::vector<Float> &wl, Layout layout)
+        : ISpectralImage(w, h), wavelenghts(sorted_unique(wl)), layout(layout), pixel_stride(), band_stride(),
+          data(long(w) * long(h) * wavelenghts.size(), 0.0f), spectra(), statistics()
+    {
+        if(layout == Layout::PIXEL_INTERLEAVED) {
+            pixel_stride = wavelenghts.size();
+            band_stride = 1;
+        }
+        else {
+            pixel_stride = 1;
+            band_stride = long(w) * long(h);
+        }
+        bind_spectra();
+    }
+
+    DenseSpectralImage::DenseSpectralImage(const DenseSpectralImage &image)
+        : ISpectralImage(image.width, image.height), wavelenghts(image.wavelenghts), layout(image.layout),
+          pixel_stride(image.pixel_stride), band_stride(image.band_stride), data(image.data), spectra(), statistics(image.statistics)
+    {
+        bind_spectra();
+    }
+
+    DenseSpectralImage::DenseSpectralImage(DenseSpectralImage &&image)
+        : ISpectralImage(image.width, image.height), wavelenghts(std::move(image.wavelenghts)), layout(image.layout),
+          pixel_stride(image.pixel_stride), band_stride(image.band_stride), data(std::move(image.data)), spectra(std::move(image.spectra)),
+          statistics(std::move(image.statistics))
+    {
+        bind_spectra();
+    }
+
+    DenseSpectralImage &DenseSpectralImage::operator=(const DenseSpectralImage &other)
+    {
+        if(this != &other) {
+            *this = DenseSpectralImage(other);
+        }
+        return *this;
+    }
+
+    DenseSpectralImage &DenseSpectralImage::operator=(DenseSpectralImage &&other)
+    {
+        if(this != &other) {
+            width = other.width;
+            height = other.height;
+            wavelenghts = std::move(other.wavelenghts);
+            layout = other.layout;
+            pixel_stride = other.pixel_stride;
+            band_stride = other.band_stride;
+            data = std::move(other.data);
+            spectra = std::move(other.spectra);
+            statistics = std::move(other.statistics);
+            bind_spectra();
+        }
+        return *this;
+    }
+
+    void DenseSpectralImage::bind_spectra()
+    {
+        const long size = long(width) * long(height);
+        spectra.resize(size);
+        for(long i = 0; i < size; ++i) {
+            spectra[i] = SpectrumType(this, i);
+        }
+    }
+
+    DenseSpectralImage::SpectrumType &DenseSpectralImage::at(int i, int j)
+    {
+        //pixel spectra are read-only, so statistics stay valid
+        long pos = (i + long(j) * width);
+        if(pos < 0 || pos >= long(width) * height) throw std::out_of_range("Requested pixel is out of range");
+        return spectra[pos];
+    }
+
+    const DenseSpectralImage::SpectrumType &DenseSpectralImage::at(int i, int j) const
+    {
+        long pos = (i + long(j) * width);
+        if(pos < 0 || pos >= long(width) * height) throw std::out_of_range("Requested pixel is out of range");
+        return spectra[pos];
+    }
+
+    int DenseSpectralImage::find_band(Float w) const
+    {
+        auto it = std::lower_bound(wavelenghts.begin(), wavelenghts.end(), w);
+        if(it == wavelenghts.end() || *it != w) return -1;
+        return it - wavelenghts.begin();
+    }
+
+    Float DenseSpectralImage::evaluate(long pixel, Float w) const
+    {
+        auto it = std::lower_bound(wavelenghts.begin(), wavelenghts.end(), w);
+        if(it == wavelenghts.end()) {
+            return 0.0f;
+        }
+
+        const int b_id = it - wavelenghts.begin();
+        const Float f_b = value(pixel, b_id);
+        if(*it == w) return f_b;
+
+        if(b_id == 0) {
+            return 0.0f;
+        }
+
+        return math::interpolate(w, wavelenghts[b_id - 1], *it, value(pixel, b_id - 1), f_b);
+    }
+
+    BandStatistics::ptr DenseSpectralImage::get_band_statistics() const
+    {
+        BandStatistics::ptr result;
+        #pragma omp critical(band_statistics)
+        {
+            if(!statistics) statistics = _compute_statistics(*this);
+            result = statistics;
+        }
+        return result;
+    }
+
+}
@@ -1,11 +1,13 @@
 #include <spec/fourier_lut.h>
 #include <internal/serialization/binary.h>
+#include <internal/serialization/lut_file.h>
 
 #include <spec/spectral_util.h>
 #include <spec/conversions.h>
 #include <spec/fourier_spectrum.h>
 
-#include <iostream>
+#include <algorithm>
+#include <fstream>
 namespace spec {
 
     namespace {
@@ -33,9 +35,41 @@ namespace spec {
 
     std::vector<Float> FourierLUT::eval(int r, int g, int b, Float power) const
     {
-         if(!validate_c(r, g, b)) {
+        if(!validate_c(r, g, b)) {
             return {};
         }
+
+        std::vector<Float> res(m + 1);
+        eval_to({r, g, b}, power, res.data());
+        return res;
+    }
+
+    bool FourierLUT::eval(int r, int g, int b, Float power, Float *dst) const
+    {
+        if(!validate_c(r, g, b)) {
+            return false;
+        }
+
+        eval_to({r, g, b}, power, dst);
+        return true;
+    }
+
+    void FourierLUT::eval_batch(const vec3i *rgb, const Float *power, size_t count, Float *dst) const
+    {
+        const unsigned stride = m + 1;
+        for(size_t i = 0; i < count; ++i) {
+            Float *res = dst + i * stride;
+            if(validate_c(rgb[i].x, rgb[i].y, rgb[i].z)) {
+                eval_to(rgb[i], power[i], res);
+            }
+            else {
+                std::fill(res, res + stride, 0.0f);
+            }
+        }
+    }
+
+    void FourierLUT::eval_to(const vec3i &rgb, Float power, Float *dst) const
+    {
         /*
         unsigned n = power_values.size() - 1;
         Float p_mul = 1.0f;
@@ -46,87 +80,91 @@ namespace spec {
             }
         }
         p_mul = power / power_values[n];*/
-        unsigned n = 0;
-        Float p_mul = power / power_values[0];
-
-        const int r1_id = r / step;
-        const int r2_id = safe_int(r1_id + 1, size);
-        const int g1_id = g / step;
-        const int g2_id = safe_int(g1_id + 1, size);
-        const int b1_id = b / step;
-        const int b2_id = safe_int(b1_id + 1, size);
-
-        const int r1 = safe_int(r1_id * step, 256);
-        const int r2 = r == 255 ? 256 : safe_int(r2_id * step, 256);
-        const int g1 = safe_int(g1_id * step, 256);
-        const int g2 = g == 255 ? 256 : safe_int(g2_id * step, 256);
-        const int b1 = safe_int(b1_id * step, 256);
-        const int b2 = b == 255 ? 256 : safe_int(b2_id * step, 256);
-
-        std::cout << size << " " << r1 << " " << r2 << std::endl;
-
-        const Float drf  = Float(r2 - r1) / 255.0f;
-        const Float drf1 = Float(r - r1) / 255.0f;
-        const Float drf2 = Float(r2 - r) / 255.0f;
-
-        const Float dgf  = Float(g2 - g1) / 255.0f;
-        const Float dgf1 = Float(g - g1) / 255.0f;
-        const Float dgf2 = Float(g2 - g) / 255.0f;
-
-        const Float dbf  = Float(b2 - b1) / 255.0f;
-        const Float dbf1 = Float(b - b1) / 255.0f;
-        const Float dbf2 = Float(b2 - b) / 255.0f;
-
-        Float t = drf * dgf * dbf;
-        const Float div = t > 0.0f ? (1.0f / t) : 1.0f;
+        const unsigned n = 0;
+        const Float p_mul = power / power_values[0];
 
-        std::vector<Float> res(m + 1, 0.0f);
+        const Axis &r = axes[rgb.x];
+        const Axis &g = axes[rgb.y];
+        const Axis &b = axes[rgb.z];
 
-        add(res, r1_id, g1_id, b1_id, n, drf2 * dgf2 * dbf2 * div * p_mul);
-        add(res, r1_id, g1_id, b2_id, n, drf2 * dgf2 * dbf1 * div * p_mul);
-        add(res, r1_id, g2_id, b1_id, n, drf2 * dgf1 * dbf2 * div * p_mul);
-        add(res, r1_id, g2_id, b2_id, n, drf2 * dgf1 * dbf1 * div * p_mul);
-        add(res, r2_id, g1_id, b1_id, n, drf1 * dgf2 * dbf2 * div * p_mul);
-        add(res, r2_id, g1_id, b2_id, n, drf1 * dgf2 * dbf1 * div * p_mul);
-        add(res, r2_id, g2_id, b1_id, n, drf1 * dgf1 * dbf2 * div * p_mul);
-        add(res, r2_id, g2_id, b2_id, n, drf1 * dgf1 * dbf1 * div * p_mul);
+        const Float t = r.d * g.d * b.d;
+        const Float div = t > 0.0f ? (1.0f / t) : 1.0f;
 
-//        for(unsigned i = 0; i <= m; ++i) std::cout << res[i] << ",";
-//        std::cout << std::endl;
+        std::fill(dst, dst + m + 1, 0.0f);
 
+        add(dst, r.id1, g.id1, b.id1, n, r.d2 * g.d2 * b.d2 * div * p_mul);
+        add(dst, r.id1, g.id1, b.id2, n, r.d2 * g.d2 * b.d1 * div * p_mul);
+        add(dst, r.id1, g.id2, b.id1, n, r.d2 * g.d1 * b.d2 * div * p_mul);
+        add(dst, r.id1, g.id2, b.id2, n, r.d2 * g.d1 * b.d1 * div * p_mul);
+        add(dst, r.id2, g.id1, b.id1, n, r.d1 * g.d2 * b.d2 * div * p_mul);
+        add(dst, r.id2, g.id1, b.id2, n, r.d1 * g.d2 * b.d1 * div * p_mul);
+        add(dst, r.id2, g.id2, b.id1, n, r.d1 * g.d1 * b.d2 * div * p_mul);
+        add(dst, r.id2, g.id2, b.id2, n, r.d1 * g.d1 * b.d1 * div * p_mul);
+    }
 
-        for(Float f : res) {
-            if(std::isnan(f)) std::cout << "NAN" << std::endl;
+    void FourierLUT::build_axes()
+    {
+        axes.resize(256);
+        for(int c = 0; c < 256; ++c) {
+            const int id1 = c / step;
+            const int id2 = safe_int(id1 + 1, size);
+            const int c1 = safe_int(id1 * step, 256);
+            const int c2 = c == 255 ? 256 : safe_int(id2 * step, 256);
+            axes[c] = Axis{unsigned(id1), unsigned(id2), Float(c2 - c1) / 255.0f, Float(c - c1) / 255.0f, Float(c2 - c) / 255.0f};
         }
+    }
 
-        return res;
+    void FourierLUT::save_to(std::ostream &dst) const
+    {
+        lut_file::write(dst, FILE_MARKER, step, m, power_values, reinterpret_cast<const char *>(raw), data_size() * sizeof(Float));
     }
 
     FourierLUT FourierLUT::load_from(std::istream &src)
     {
+        if(lut_file::is_v2(src, FILE_MARKER)) {
+            std::vector<Float> power_values;
+            const lut_file::Header header = lut_file::read_header(src, FILE_MARKER, power_values);
+            FourierLUT lut{power_values, header.step, header.m};
+            if(header.payload_size != lut.data.size() * sizeof(Float)) throw std::invalid_argument("LUT size doesn't match its parameters");
+            lut_file::read_payload(src, header, power_values, reinterpret_cast<char *>(lut.data.data()));
+            return lut;
+        }
+
         if(!validate_header(src)) throw std::invalid_argument("Unsupported file");
         uint16_t step = binary::read<uint16_t>(src);
         uint16_t m = binary::read<uint16_t>(src);
 
         uint16_t p_size = binary::read<uint16_t>(src);
         std::vector<Float> power_values(p_size);
-        for(unsigned i = 0; i < p_size; ++i) {
-            power_values[i] = binary::read<Float>(src);
-        }
+        binary::read_array<Float>(src, power_values.data(), p_size);
 
         FourierLUT lut{power_values, step, m};
-        const unsigned size = power_values.size() * lut.size * lut.size * lut.size * (m + 1);
-        for(unsigned i = 0; i < size; ++i) {
-            lut.data[i] = binary::read<Float>(src);
+        binary::read_array<Float>(src, lut.data.data(), lut.data.size());
+        if(!src) throw std::invalid_argument("LUT file is truncated");
+        return lut;
+    }
+
+    FourierLUT FourierLUT::load_from_file(const std::string &path)
+    {
+        MappedFile::ptr file = MappedFile::open(path);
+        if(!lut_file::is_v2(file->data(), file->size(), FILE_MARKER)) {
+            std::ifstream src{path, std::ios::binary};
+            return load_from(src);
         }
+
+        const lut_file::View view = lut_file::parse(file->data(), file->size(), FILE_MARKER);
+        const std::vector<Float> power_values(view.power_values, view.power_values + view.header.power_count);
+        const Float *payload = reinterpret_cast<const Float *>(view.payload);
+        FourierLUT lut{std::move(file), payload, power_values, view.header.step, view.header.m};
+        if(view.header.payload_size != lut.data_size() * sizeof(Float)) throw std::invalid_argument("LUT size doesn't match its parameters");
         return lut;
     }
 
-    void FourierLUT::add(std::vector<Float> &res, unsigned r, unsigned g, unsigned b, unsigned n, Float mul) const
+    void FourierLUT::add(Float *res, unsigned r, unsigned g, unsigned b, unsigned n, Float mul) const
     {
         unsigned offset = (((n * size + r) * size + g) * size + b) * (m + 1);
         for(unsigned i = 0; i <= m; ++i) {
-            res[i] += data[offset + i] * mul;
+            res[i] += raw[offset + i] * mul;
         }
       /*  std::cout << "ADDING: " << r * step << " " << g * step << " " << b * step << " with ";
         //for(unsigned i = 0; i <= m; ++i) std::cout << res[i] << ",";
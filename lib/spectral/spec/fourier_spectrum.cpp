@@ -1,24 +1,116 @@
 #include <spec/fourier_spectrum.h>
+#include <algorithm>
+#include <stdexcept>
+#include <string>
 
 namespace spec {
 
-    Float FourierReflectanceSpectrum::get_or_interpolate(Float w) const
+    namespace {
+
+        /**
+         *  Calls fn with phase grid of n wavelenghts given by wl(i), shared CIE grid is used if wavelenghts match it.
+         */
+        template<typename WlFn, typename Fn>
+        void _with_grid(WlFn wl, size_t n, int max_m, const Fn &fn)
+        {
+            const math::PhaseGrid &cie = math::cie_phase_grid();
+            bool is_cie = n == cie.size() && max_m <= cie.get_max_m();
+            for(size_t i = 0; is_cie && i < n; ++i) {
+                is_cie = wl(i) == Float(WAVELENGHTS_START + long(i) * WAVELENGHTS_STEP);
+            }
+            if(is_cie) {
+                fn(cie);
+                return;
+            }
+
+            std::vector<Float> phases(n);
+            for(size_t i = 0; i < n; ++i) {
+                phases[i] = math::to_phase(wl(i));
+            }
+            fn(math::PhaseGrid{phases, max_m});
+        }
+
+        template<typename T>
+        inline const std::vector<T> &_require_precomputed(const std::vector<T> &v, const std::string &what)
+        {
+            if(v.empty()) throw std::runtime_error(what + " has to be precomputed before evaluation");
+            return v;
+        }
+
+    }
+
+    void FourierReflectanceSpectrum::precompute()
     {
-        if(lagrange_m.empty()) {
+        if(lagrange_m.empty() && !coef.empty()) {
             lagrange_m = math::lagrange_multipliers(coef);
         }
+    }
 
-        return math::bounded_mese_l(math::to_phase(w), lagrange_m);
+    const std::vector<Complex> &FourierReflectanceSpectrum::get_lagrange_multipliers() const
+    {
+        return _require_precomputed(lagrange_m, "Fourier spectrum");
     }
 
-    Float FourierEmissionSpectrum::get_or_interpolate(Float w) const
+    Float FourierReflectanceSpectrum::get_or_interpolate(Float w) const
     {
-        if(coef[0] == 0) return 0.0f;
-        if(q_vector.empty()) {
+        return math::bounded_mese_l(math::to_phase(w), get_lagrange_multipliers());
+    }
+
+    void FourierReflectanceSpectrum::sample_into(const Float *wavelenghts, size_t n, Float *out) const
+    {
+        const std::vector<Complex> &l = get_lagrange_multipliers();
+
+        const int M = l.size() - 1;
+        _with_grid([wavelenghts](size_t i) { return wavelenghts[i]; }, n, M, [&](const math::PhaseGrid &grid) {
+            grid.bounded_mese_l(l.data(), M, out);
+        });
+    }
+
+    void FourierReflectanceSpectrum::sample_into(Float start, Float step, size_t n, Float *out) const
+    {
+        const std::vector<Complex> &l = get_lagrange_multipliers();
+
+        const int M = l.size() - 1;
+        _with_grid([start, step](size_t i) { return start + i * step; }, n, M, [&](const math::PhaseGrid &grid) {
+            grid.bounded_mese_l(l.data(), M, out);
+        });
+    }
+
+    void FourierEmissionSpectrum::precompute()
+    {
+        if(q_vector.empty() && !coef.empty() && coef[0] != 0) {
             q_vector = math::precompute_mese_coeffs(coef);
         }
+    }
 
-        return math::mese_precomp(math::to_phase(w), q_vector);
+    Float FourierEmissionSpectrum::get_or_interpolate(Float w) const
+    {
+        if(coef[0] == 0) return 0.0f;
+        return math::mese_precomp(math::to_phase(w), _require_precomputed(q_vector, "Fourier spectrum"));
+    }
+
+    void FourierEmissionSpectrum::sample_into(const Float *wavelenghts, size_t n, Float *out) const
+    {
+        _with_grid([wavelenghts](size_t i) { return wavelenghts[i]; }, n, coef.size() - 1, [&](const math::PhaseGrid &grid) {
+            sample(grid, out);
+        });
+    }
+
+    void FourierEmissionSpectrum::sample_into(Float start, Float step, size_t n, Float *out) const
+    {
+        _with_grid([start, step](size_t i) { return start + i * step; }, n, coef.size() - 1, [&](const math::PhaseGrid &grid) {
+            sample(grid, out);
+        });
+    }
+
+    void FourierEmissionSpectrum::sample(const math::PhaseGrid &grid, Float *dst) const
+    {
+        if(coef[0] == 0) {
+            std::fill(dst, dst + grid.size(), 0.0f);
+            return;
+        }
+        const std::vector<Float> &q = _require_precomputed(q_vector, "Fourier spectrum");
+        grid.mese(q.data(), q.size() - 1, dst);
     }
 /*
     Float LFourierSpectrum::get_or_interpolate(Float w) const
@@ -28,7 +120,153 @@ namespace spec {
 */
 
     template class SpectralImage<FourierReflectanceSpectrum>;
-    template class SpectralImage<FourierEmissionSpectrum>;
+
+    void FourierReflectanceSpectralImage::precompute()
+    {
+        const long size = long(width) * height;
+
+        #pragma omp parallel for schedule(dynamic, 256)
+        for(long i = 0; i < size; ++i) {
+            data[i].precompute();
+        }
+    }
+
+    bool FourierReflectanceSpectralImage::is_precomputed() const
+    {
+        return std::all_of(data.begin(), data.end(), [](const FourierReflectanceSpectrum &s) { return s.is_precomputed(); });
+    }
+    template<>
+    void PixelSpectrum<FourierEmissionSpectralImage>::sample_into(const Float *wavelenghts, size_t n, Float *out) const
+    {
+        _with_grid([wavelenghts](size_t i) { return wavelenghts[i]; }, n, image->get_m(), [&](const math::PhaseGrid &grid) {
+            image->sample(pixel, grid, out);
+        });
+    }
+
+    template<>
+    void PixelSpectrum<FourierEmissionSpectralImage>::sample_into(Float start, Float step, size_t n, Float *out) const
+    {
+        _with_grid([start, step](size_t i) { return start + i * step; }, n, image->get_m(), [&](const math::PhaseGrid &grid) {
+            image->sample(pixel, grid, out);
+        });
+    }
+
+    template class PixelSpectrum<FourierEmissionSpectralImage>;
    // template class SpectralImage<LFourierSpectrum>;
 
-}
\ No newline at end of file
+
+    FourierEmissionSpectralImage::FourierEmissionSpectralImage()
+        : ISpectralImage(0, 0), m(0), coef(), q(), spectra() {}
+
+    FourierEmissionSpectralImage::FourierEmissionSpectralImage(int w, int h, unsigned m)
+        : ISpectralImage(w, h), m(m), coef(long(w) * long(h) * (m + 1), 0.0f), q(), spectra()
+    {
+        bind_spectra();
+    }
+
+    FourierEmissionSpectralImage::FourierEmissionSpectralImage(const FourierEmissionSpectralImage &image)
+        : ISpectralImage(image.width, image.height), m(image.m), coef(image.coef), q(image.q), spectra()
+    {
+        bind_spectra();
+    }
+
+    FourierEmissionSpectralImage::FourierEmissionSpectralImage(FourierEmissionSpectralImage &&image)
+        : ISpectralImage(image.width, image.height), m(image.m), coef(std::move(image.coef)), q(std::move(image.q)), spectra(std::move(image.spectra))
+    {
+        bind_spectra();
+    }
+
+    FourierEmissionSpectralImage &FourierEmissionSpectralImage::operator=(const FourierEmissionSpectralImage &other)
+    {
+        if(this != &other) {
+            *this = FourierEmissionSpectralImage(other);
+        }
+        return *this;
+    }
+
+    FourierEmissionSpectralImage &FourierEmissionSpectralImage::operator=(FourierEmissionSpectralImage &&other)
+    {
+        if(this != &other) {
+            width = other.width;
+            height = other.height;
+            m = other.m;
+            coef = std::move(other.coef);
+            q = std::move(other.q);
+            spectra = std::move(other.spectra);
+            bind_spectra();
+        }
+        return *this;
+    }
+
+    void FourierEmissionSpectralImage::bind_spectra()
+    {
+        const long size = long(width) * long(height);
+        spectra.resize(size);
+        for(long i = 0; i < size; ++i) {
+            spectra[i] = SpectrumType(this, i);
+        }
+    }
+
+    FourierEmissionSpectralImage::SpectrumType &FourierEmissionSpectralImage::at(int i, int j)
+    {
+        long pos = (i + long(j) * width);
+        if(pos < 0 || pos >= long(width) * height) throw std::out_of_range("Requested pixel is out of range");
+        return spectra[pos];
+    }
+
+    const FourierEmissionSpectralImage::SpectrumType &FourierEmissionSpectralImage::at(int i, int j) const
+    {
+        long pos = (i + long(j) * width);
+        if(pos < 0 || pos >= long(width) * height) throw std::out_of_range("Requested pixel is out of range");
+        return spectra[pos];
+    }
+
+    void FourierEmissionSpectralImage::precompute()
+    {
+        constexpr long CHUNK = 256;
+
+        const long size = long(width) * height;
+        const unsigned stride = get_stride();
+        std::vector<Float> res(coef.size());
+
+        #pragma omp parallel for schedule(static)
+        for(long start = 0; start < size; start += CHUNK) {
+            const long count = std::min(CHUNK, size - start);
+            math::precompute_mese_coeffs(coef.data() + start * stride, count, m, res.data() + start * stride);
+        }
+        q = std::move(res);
+    }
+
+    Float FourierEmissionSpectralImage::evaluate(long pixel, Float w) const
+    {
+        const Float *c = coefficients(pixel);
+        if(c[0] == 0) return 0.0f;
+        _require_precomputed(q, "Fourier image");
+        return math::mese_precomp(math::to_phase(w), q.data() + pixel * get_stride(), m);
+    }
+
+
+    void FourierEmissionSpectralImage::sample(long pixel, const math::PhaseGrid &grid, Float *dst) const
+    {
+        const Float *c = coefficients(pixel);
+        if(c[0] == 0) {
+            std::fill(dst, dst + grid.size(), 0.0f);
+            return;
+        }
+        _require_precomputed(q, "Fourier image");
+        grid.mese(q.data() + pixel * get_stride(), m, dst);
+    }
+
+    void require_precomputed(const ISpectralImage &img)
+    {
+        if(long(img.get_width()) * img.get_height() == 0) return;
+
+        if(isa<FourierReflectanceSpectralImage>(img) && !static_cast<const FourierReflectanceSpectralImage &>(img).is_precomputed()) {
+            throw std::runtime_error("Fourier image has to be precomputed before evaluation");
+        }
+        if(isa<FourierEmissionSpectralImage>(img) && !static_cast<const FourierEmissionSpectralImage &>(img).is_precomputed()) {
+            throw std::runtime_error("Fourier image has to be precomputed before evaluation");
+        }
+    }
+
+}
@@ -2,6 +2,7 @@
 #include <spec/conversions.h>
 #include <internal/common/constants.h>
 #include <cassert>
+#include <vector>
 
 namespace spec::metrics {
 
@@ -14,35 +15,39 @@ namespace spec::metrics {
 //------SPECTRA------
     Float mae(const ISpectrum &y1, const ISpectrum &y2, const std::vector<Float> &wavelenghts)
     {
+        const size_t n = wavelenghts.size();
+        std::vector<Float> v1(n), v2(n);
+        y1.sample_into(wavelenghts.data(), n, v1.data());
+        y2.sample_into(wavelenghts.data(), n, v2.data());
+
         Float res = 0.0f;
-        for(Float wl : wavelenghts) {
-            res += std::fabs(y1(wl) - y2(wl));
+        for(size_t i = 0; i < n; ++i) {
+            res += std::fabs(v1[i] - v2[i]);
         }
         return res / Float((WAVELENGHTS_END - WAVELENGHTS_START) / WAVELENGHTS_STEP);
     }
 
     Float sam(const ISpectrum &y1, const ISpectrum &y2, const std::vector<Float> &wavelenghts)
     {
+        const size_t n = wavelenghts.size();
+        std::vector<Float> v1(n), v2(n);
+        y1.sample_into(wavelenghts.data(), n, v1.data());
+        y2.sample_into(wavelenghts.data(), n, v2.data());
+
         Float dist1 = 0.0f;
         Float dist2 = 0.0f;
         Float dot = 0.0f;
-        for(Float wl : wavelenghts)
+        for(size_t i = 0; i < n; ++i)
         {
-            const Float val1 = y1(wl);
+            const Float val1 = v1[i];
             dist1 += val1 * val1;
-            const Float val2 = y2(wl);
+            const Float val2 = v2[i];
             dist2 += val2 * val2;
             dot += val1 * val2;
         }
 
         if(dist1 == 0.0f || dist2 == 0.0f) {
-            for(Float wl : wavelenghts)
-            {
-                if(y1(wl) != y2(wl)) {
-                    return math::PI / 2.0f;
-                }
-            }
-            return 0.0f;
+            return v1 == v2 ? 0.0f : math::PI / 2.0f;
         }
 
         const Float mdist = std::sqrt(dist1) * std::sqrt(dist2);
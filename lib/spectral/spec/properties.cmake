@@ -6,6 +6,9 @@ set(MODULE_SOURCES
     spectral_util_load.cpp
     spectral_util.cpp
     basic_spectrum.cpp
+    sampled_spectrum.cpp
+    dense_spectral_image.cpp
+    band_statistics.cpp
     sigpoly_spectrum.cpp
     conversions.cpp
     sigpoly_lut.cpp
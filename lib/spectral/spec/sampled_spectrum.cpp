@@ -0,0 +1,146 @@
+#include <spec/sampled_spectrum.h>
+#include <internal/math/math.h>
+#include <algorithm>
+#include <stdexcept>
+#include <cmath>
+
+namespace spec {
+
+    namespace {
+
+        constexpr Float GRID_TOLERANCE = 1e-4f;
+
+        bool _less_wl(const SampledSpectrum::SampleType &s, Float w)
+        {
+            return s.first < w;
+        }
+
+        bool _same_wl(const SampledSpectrum::SampleType &a, const SampledSpectrum::SampleType &b)
+        {
+            return a.first == b.first;
+        }
+
+    }
+
+    SampledSpectrum::SampledSpectrum(std::initializer_list<SampleType> l)
+        : samples(l), uniform(false), step(0.0f), inv_step(0.0f)
+    {
+        std::sort(samples.begin(), samples.end());
+        samples.erase(std::unique(samples.begin(), samples.end(), _same_wl), samples.end());
+        update_grid();
+    }
+
+    SampledSpectrum::SampledSpectrum(const std::vector<Float> &wavelenghts, const std::vector<Float> &values)
+        : samples(), uniform(false), step(0.0f), inv_step(0.0f)
+    {
+        if(wavelenghts.size() != values.size()) throw std::invalid_argument("Sizes of wavelenghts and values differ");
+
+        samples.reserve(wavelenghts.size());
+        for(unsigned i = 0; i < wavelenghts.size(); ++i) {
+            samples.emplace_back(wavelenghts[i], values[i]);
+        }
+        std::sort(samples.begin(), samples.end());
+        samples.erase(std::unique(samples.begin(), samples.end(), _same_wl), samples.end());
+        update_grid();
+    }
+
+    SampledSpectrum::SampledSpectrum(Float start, Float step, const std::vector<Float> &values)
+        : samples(), uniform(false), step(0.0f), inv_step(0.0f)
+    {
+        samples.reserve(values.size());
+        for(unsigned i = 0; i < values.size(); ++i) {
+            samples.emplace_back(start + i * step, values[i]);
+        }
+        update_grid();
+    }
+
+    bool SampledSpectrum::fits_grid(Float delta) const
+    {
+        return std::abs(delta - step) <= step * GRID_TOLERANCE;
+    }
+
+    void SampledSpectrum::update_grid()
+    {
+        uniform = false;
+        if(samples.size() < 2) return;
+
+        step = samples[1].first - samples[0].first;
+        for(unsigned i = 2; i < samples.size(); ++i) {
+            if(!fits_grid(samples[i].first - samples[i - 1].first)) return;
+        }
+        inv_step = 1.0f / step;
+        uniform = true;
+    }
+
+    void SampledSpectrum::set(Float wavelenght, Float value)
+    {
+        //fast path for filling in ascending order
+        if(samples.empty() || samples.back().first < wavelenght) {
+            samples.emplace_back(wavelenght, value);
+            const size_t n = samples.size();
+            if(n == 2) {
+                update_grid();
+            }
+            else if(n > 2 && uniform) {
+                uniform = fits_grid(wavelenght - samples[n - 2].first);
+            }
+            return;
+        }
+
+        auto it = std::lower_bound(samples.begin(), samples.end(), wavelenght, _less_wl);
+        if(it->first == wavelenght) {
+            it->second = value;
+            return;
+        }
+        samples.emplace(it, wavelenght, value);
+        update_grid();
+    }
+
+    Float SampledSpectrum::operator[](Float w) const
+    {
+        auto it = std::lower_bound(samples.begin(), samples.end(), w, _less_wl);
+        if(it == samples.end() || it->first != w) throw std::out_of_range("No sample at specified wavelenght");
+        return it->second;
+    }
+
+    Float SampledSpectrum::get_or_interpolate(Float w) const
+    {
+        if(samples.empty() || w < samples.front().first || w > samples.back().first) {
+            return 0.0f;
+        }
+
+        long b_id;
+        if(uniform) {
+            const long last = samples.size() - 1;
+            b_id = std::min(long((w - samples.front().first) * inv_step) + 1, last);
+            //grid is uniform only up to tolerance, so correct the interval if needed
+            while(b_id > 0 && samples[b_id - 1].first >= w) --b_id;
+            while(b_id < last && samples[b_id].first < w) ++b_id;
+        }
+        else {
+            b_id = std::lower_bound(samples.begin(), samples.end(), w, _less_wl) - samples.begin();
+        }
+
+        const SampleType &b = samples[b_id];
+        if(b.first == w) return b.second;
+        if(b_id == 0) return 0.0f;
+
+        const SampleType &a = samples[b_id - 1];
+        return math::interpolate(w, a.first, b.first, a.second, b.second);
+    }
+
+    void SampledSpectrum::sample_into(const Float *wavelenghts, size_t n, Float *out) const
+    {
+        for(size_t i = 0; i < n; ++i) {
+            out[i] = SampledSpectrum::get_or_interpolate(wavelenghts[i]);
+        }
+    }
+
+    void SampledSpectrum::sample_into(Float start, Float step, size_t n, Float *out) const
+    {
+        for(size_t i = 0; i < n; ++i) {
+            out[i] = SampledSpectrum::get_or_interpolate(start + i * step);
+        }
+    }
+
+}
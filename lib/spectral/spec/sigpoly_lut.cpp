@@ -1,9 +1,16 @@
 #include <spec/sigpoly_lut.h>
 #include <internal/math/math.h>
 #include <internal/serialization/binary.h>
+#include <internal/serialization/lut_file.h>
 #include <cinttypes>
+#include <fstream>
 #include <stdexcept>
 
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define SPECTRAL_SIGPOLY_AVX2
+#include <immintrin.h>
+#endif
+
 namespace spec {
 
     namespace {
@@ -12,6 +19,8 @@ namespace spec {
             return a >= 0 && a <= 255 && b >= 0 && b <= 255 && c >= 0 && c <= 255;
         }
 
+        static_assert(sizeof(vec3) == 3 * sizeof(Float), "LUT payload is used directly as array of vec3");
+
         inline int safe_int(int i, int size)
         {
             return i >= size ? size - 1 : i;
@@ -81,16 +90,249 @@ namespace spec {
              + at(a2_id, b2_id, alpha2_id) * daf1 * dbf1 * dalphaf1 * div;
     }
 
+    void SigpolyLUT::save_to(std::ostream &dst) const
+    {
+        const size_t count = size_t(size) * size * size;
+        lut_file::write(dst, FILE_MARKER, step, 0, {}, reinterpret_cast<const char *>(raw), count * sizeof(vec3));
+    }
+
     SigpolyLUT SigpolyLUT::load_from(std::istream &src)
     {
+        if(lut_file::is_v2(src, FILE_MARKER)) {
+            std::vector<Float> power_values;
+            const lut_file::Header header = lut_file::read_header(src, FILE_MARKER, power_values);
+            SigpolyLUT lut{header.step};
+            const size_t count = lut.data.size();
+            if(header.payload_size != count * sizeof(vec3)) throw std::invalid_argument("LUT size doesn't match its step");
+            lut_file::read_payload(src, header, power_values, reinterpret_cast<char *>(lut.data.data()));
+            return lut;
+        }
+
         if(!validate_header(src)) throw std::invalid_argument("Unsupported file");
         uint16_t step = binary::read<uint16_t>(src);
         SigpolyLUT lut{step};
-        const unsigned size = lut.size * lut.size * lut.size;
-        for(unsigned i = 0; i < size; ++i) {
-            lut.data[i] = binary::read_vec<Float>(src);
-        }
+        binary::read_array<Float>(src, reinterpret_cast<Float *>(lut.data.data()), lut.data.size() * 3);
+        if(!src) throw std::invalid_argument("LUT file is truncated");
         return lut;
     }
 
-}
\ No newline at end of file
+    SigpolyLUT SigpolyLUT::load_from_file(const std::string &path)
+    {
+        MappedFile::ptr file = MappedFile::open(path);
+        if(!lut_file::is_v2(file->data(), file->size(), FILE_MARKER)) {
+            std::ifstream src{path, std::ios::binary};
+            return load_from(src);
+        }
+
+        const lut_file::View view = lut_file::parse(file->data(), file->size(), FILE_MARKER);
+        const unsigned step = view.header.step;
+        const size_t size = 256 / step + (255 % step != 0);
+        if(view.header.payload_size != size * size * size * sizeof(vec3)) throw std::invalid_argument("LUT size doesn't match its step");
+        return SigpolyLUT{std::move(file), reinterpret_cast<const vec3 *>(view.payload), step};
+    }
+
+    SigpolyLUTSet::SigpolyLUTSet(SigpolyLUT &&lut0, SigpolyLUT &&lut1, SigpolyLUT &&lut2)
+        : luts{std::move(lut0), std::move(lut1), std::move(lut2)}
+    {
+        const unsigned step = luts[0].get_step();
+        const unsigned size = luts[0].get_size();
+        if(luts[1].get_step() != step || luts[2].get_step() != step) throw std::invalid_argument("LUTs have different steps");
+
+        //same computations as in SigpolyLUT::eval
+        for(int v = 0; v < int(TABLE_SIZE); ++v) {
+            const int id1 = v / step;
+            const int id2 = safe_int(id1 + 1, size);
+            const int v1 = safe_int(id1 * step, 256);
+            const int v2 = v == 255 ? 256 : safe_int(id2 * step, 256);
+
+            a_off1[v] = id1 * size * 3;
+            a_off2[v] = id2 * size * 3;
+            b_off1[v] = id1 * 3;
+            b_off2[v] = id2 * 3;
+            ab_d[v] = (v2 - v1) / 255.0f;
+            ab_d1[v] = (v - v1) / 255.0f;
+            ab_d2[v] = (v2 - v) / 255.0f;
+
+            const Float alphaf = v / 255.0f;
+            const unsigned alpha1_id = static_cast<int>((size - 1) * math::inv_smoothstep2(alphaf));
+            const unsigned alpha2_id = alpha1_id == size - 1 ? size - 1 : alpha1_id + 1;
+            const Float alphaf1 = math::smoothstep2(alpha1_id / static_cast<Float>(size - 1));
+            const Float alphaf2 = alpha1_id == alpha2_id ? 2.0f : math::smoothstep2(alpha2_id / static_cast<Float>(size - 1));
+
+            alpha_off1[v] = alpha1_id * size * size * 3;
+            alpha_off2[v] = alpha2_id * size * size * 3;
+            alpha_d[v] = alphaf2 - alphaf1;
+            alpha_d1[v] = alphaf - alphaf1;
+            alpha_d2[v] = alphaf2 - alphaf;
+        }
+    }
+
+    void SigpolyLUTSet::eval_to(const Pixel &pixel, Float *dst) const
+    {
+        const int m = pixel[0] >= pixel[1] ? 0 : 1;
+        const int amax = pixel[m] >= pixel[2] ? m : 2;
+        const int alpha = pixel[amax];
+        int a = 0, b = 0;
+        if(alpha != 0) {
+            a = pixel[(amax + 1) % 3] / static_cast<Float>(alpha) * 255.0f;
+            b = pixel[(amax + 2) % 3] / static_cast<Float>(alpha) * 255.0f;
+        }
+
+        const Float t = ab_d[a] * ab_d[b] * alpha_d[alpha];
+        const Float div = t > 0 ? (1.0f / t) : 1.0f;
+
+        const long a1b1 = a_off1[a] + b_off1[b];
+        const long a1b2 = a_off1[a] + b_off2[b];
+        const long a2b1 = a_off2[a] + b_off1[b];
+        const long a2b2 = a_off2[a] + b_off2[b];
+        const long al1 = alpha_off1[alpha];
+        const long al2 = alpha_off2[alpha];
+
+        const Float da1 = ab_d1[a], da2 = ab_d2[a];
+        const Float db1 = ab_d1[b], db2 = ab_d2[b];
+        const Float dal1 = alpha_d1[alpha], dal2 = alpha_d2[alpha];
+
+        const Float *data = reinterpret_cast<const Float *>(luts[amax].get_raw_data());
+        for(int c = 0; c < 3; ++c) {
+            const Float *d = data + c;
+            dst[c] = d[a1b1 + al1] * da2 * db2 * dal2 * div
+                   + d[a1b1 + al2] * da2 * db2 * dal1 * div
+                   + d[a1b2 + al1] * da2 * db1 * dal2 * div
+                   + d[a1b2 + al2] * da2 * db1 * dal1 * div
+                   + d[a2b1 + al1] * da1 * db2 * dal2 * div
+                   + d[a2b1 + al2] * da1 * db2 * dal1 * div
+                   + d[a2b2 + al1] * da1 * db1 * dal2 * div
+                   + d[a2b2 + al2] * da1 * db1 * dal1 * div;
+        }
+    }
+
+    vec3 SigpolyLUTSet::eval(const Pixel &pixel) const
+    {
+        Float c[3];
+        eval_to(pixel, c);
+        return {c[0], c[1], c[2]};
+    }
+
+#ifdef SPECTRAL_SIGPOLY_AVX2
+    namespace {
+
+        //fma is left out on purpose so that results match scalar code exactly
+        __attribute__((target("avx2")))
+        inline __m256 lut_term(const Float *data, __m256i idx, __m256 mask, __m256 w1, __m256 w2, __m256 w3, __m256 div)
+        {
+            const __m256 v = _mm256_mask_i32gather_ps(_mm256_setzero_ps(), data, idx, mask, 4);
+            return _mm256_mul_ps(_mm256_mul_ps(_mm256_mul_ps(_mm256_mul_ps(v, w1), w2), w3), div);
+        }
+
+    }
+
+    __attribute__((target("avx2")))
+    void SigpolyLUTSet::eval_batch_avx2(const Pixel *src, size_t count, Float *dst) const
+    {
+        constexpr int LANES = 8;
+        alignas(32) int32_t channels[3][LANES];
+        alignas(32) Float out[3][LANES];
+
+        const __m256i ones = _mm256_set1_epi32(1);
+        const __m256 scale = _mm256_set1_ps(255.0f);
+        const __m256 onef = _mm256_set1_ps(1.0f);
+
+        const size_t vec_count = count - count % LANES;
+        for(size_t i = 0; i < vec_count; i += LANES) {
+            for(int k = 0; k < LANES; ++k) {
+                channels[0][k] = src[i + k].r;
+                channels[1][k] = src[i + k].g;
+                channels[2][k] = src[i + k].b;
+            }
+            const __m256i r = _mm256_load_si256(reinterpret_cast<const __m256i *>(channels[0]));
+            const __m256i g = _mm256_load_si256(reinterpret_cast<const __m256i *>(channels[1]));
+            const __m256i b = _mm256_load_si256(reinterpret_cast<const __m256i *>(channels[2]));
+
+            //argmax with the same tie breaking as scalar code
+            const __m256i is_g = _mm256_cmpgt_epi32(g, r);
+            const __m256i max_rg = _mm256_max_epi32(r, g);
+            const __m256i is_b = _mm256_cmpgt_epi32(b, max_rg);
+            const __m256i alpha = _mm256_max_epi32(max_rg, b);
+
+            //channels following the maximal one
+            const __m256i c1 = _mm256_blendv_epi8(_mm256_blendv_epi8(g, b, is_g), r, is_b);
+            const __m256i c2 = _mm256_blendv_epi8(_mm256_blendv_epi8(b, r, is_g), g, is_b);
+            const __m256i amax = _mm256_blendv_epi8(_mm256_and_si256(ones, is_g), _mm256_add_epi32(ones, ones), is_b);
+
+            //black pixel has all channels 0, dividing by 1 yields a = b = 0
+            const __m256 alphaf = _mm256_cvtepi32_ps(_mm256_max_epi32(alpha, ones));
+            const __m256i ai = _mm256_cvttps_epi32(_mm256_mul_ps(_mm256_div_ps(_mm256_cvtepi32_ps(c1), alphaf), scale));
+            const __m256i bi = _mm256_cvttps_epi32(_mm256_mul_ps(_mm256_div_ps(_mm256_cvtepi32_ps(c2), alphaf), scale));
+
+            const __m256 t = _mm256_mul_ps(_mm256_mul_ps(_mm256_i32gather_ps(ab_d, ai, 4), _mm256_i32gather_ps(ab_d, bi, 4)),
+                                           _mm256_i32gather_ps(alpha_d, alpha, 4));
+            const __m256 div = _mm256_blendv_ps(onef, _mm256_div_ps(onef, t), _mm256_cmp_ps(t, _mm256_setzero_ps(), _CMP_GT_OQ));
+
+            const __m256i a1 = _mm256_i32gather_epi32(a_off1, ai, 4);
+            const __m256i a2 = _mm256_i32gather_epi32(a_off2, ai, 4);
+            const __m256i b1 = _mm256_i32gather_epi32(b_off1, bi, 4);
+            const __m256i b2 = _mm256_i32gather_epi32(b_off2, bi, 4);
+            const __m256i al1 = _mm256_i32gather_epi32(alpha_off1, alpha, 4);
+            const __m256i al2 = _mm256_i32gather_epi32(alpha_off2, alpha, 4);
+
+            const __m256i a1b1 = _mm256_add_epi32(a1, b1);
+            const __m256i a1b2 = _mm256_add_epi32(a1, b2);
+            const __m256i a2b1 = _mm256_add_epi32(a2, b1);
+            const __m256i a2b2 = _mm256_add_epi32(a2, b2);
+
+            const __m256 da1 = _mm256_i32gather_ps(ab_d1, ai, 4), da2 = _mm256_i32gather_ps(ab_d2, ai, 4);
+            const __m256 db1 = _mm256_i32gather_ps(ab_d1, bi, 4), db2 = _mm256_i32gather_ps(ab_d2, bi, 4);
+            const __m256 dal1 = _mm256_i32gather_ps(alpha_d1, alpha, 4), dal2 = _mm256_i32gather_ps(alpha_d2, alpha, 4);
+
+            //LUTs are separate buffers, lanes are gathered only from the LUT of their maximal channel
+            __m256 res[3] = {_mm256_setzero_ps(), _mm256_setzero_ps(), _mm256_setzero_ps()};
+            for(int l = 0; l < 3; ++l) {
+                const __m256i lut_mask = _mm256_cmpeq_epi32(amax, _mm256_set1_epi32(l));
+                if(_mm256_testz_si256(lut_mask, lut_mask)) continue;
+                const __m256 m = _mm256_castsi256_ps(lut_mask);
+                const Float *data = reinterpret_cast<const Float *>(luts[l].get_raw_data());
+                for(int c = 0; c < 3; ++c) {
+                    const Float *d = data + c;
+                    __m256 sum = lut_term(d, _mm256_add_epi32(a1b1, al1), m, da2, db2, dal2, div);
+                    sum = _mm256_add_ps(sum, lut_term(d, _mm256_add_epi32(a1b1, al2), m, da2, db2, dal1, div));
+                    sum = _mm256_add_ps(sum, lut_term(d, _mm256_add_epi32(a1b2, al1), m, da2, db1, dal2, div));
+                    sum = _mm256_add_ps(sum, lut_term(d, _mm256_add_epi32(a1b2, al2), m, da2, db1, dal1, div));
+                    sum = _mm256_add_ps(sum, lut_term(d, _mm256_add_epi32(a2b1, al1), m, da1, db2, dal2, div));
+                    sum = _mm256_add_ps(sum, lut_term(d, _mm256_add_epi32(a2b1, al2), m, da1, db2, dal1, div));
+                    sum = _mm256_add_ps(sum, lut_term(d, _mm256_add_epi32(a2b2, al1), m, da1, db1, dal2, div));
+                    sum = _mm256_add_ps(sum, lut_term(d, _mm256_add_epi32(a2b2, al2), m, da1, db1, dal1, div));
+                    res[c] = _mm256_blendv_ps(res[c], sum, m);
+                }
+            }
+            for(int c = 0; c < 3; ++c) {
+                _mm256_store_ps(out[c], res[c]);
+            }
+
+            for(int k = 0; k < LANES; ++k) {
+                dst[(i + k) * 3] = out[0][k];
+                dst[(i + k) * 3 + 1] = out[1][k];
+                dst[(i + k) * 3 + 2] = out[2][k];
+            }
+        }
+
+        for(size_t i = vec_count; i < count; ++i) {
+            eval_to(src[i], dst + i * 3);
+        }
+    }
+#endif
+
+    void SigpolyLUTSet::eval_batch(const Pixel *src, size_t count, Float *dst) const
+    {
+#ifdef SPECTRAL_SIGPOLY_AVX2
+        static const bool has_avx2 = __builtin_cpu_supports("avx2");
+        if(has_avx2) {
+            eval_batch_avx2(src, count, dst);
+            return;
+        }
+#endif
+        for(size_t i = 0; i < count; ++i) {
+            eval_to(src[i], dst + i * 3);
+        }
+    }
+
+}
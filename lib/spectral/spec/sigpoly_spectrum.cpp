@@ -7,6 +7,20 @@ namespace spec {
     {
         return math::sigmoid_polynomial(w, coef.v);
     }
+
+    void SigPolySpectrum::sample_into(const Float *wavelenghts, size_t n, Float *out) const
+    {
+        for(size_t i = 0; i < n; ++i) {
+            out[i] = math::sigmoid_polynomial(wavelenghts[i], coef.v);
+        }
+    }
+
+    void SigPolySpectrum::sample_into(Float start, Float step, size_t n, Float *out) const
+    {
+        for(size_t i = 0; i < n; ++i) {
+            out[i] = math::sigmoid_polynomial(start + i * step, coef.v);
+        }
+    }
     
     template class SpectralImage<SigPolySpectrum>;
 
@@ -1,5 +1,6 @@
 #include <spec/spectral_util.h>
 #include <internal/common/lazy_value.h>
+#include <memory>
 
 #ifdef SPECTRAL_ENABLE_OPENMP
 #include <omp.h>
@@ -11,6 +12,18 @@ namespace spec::util {
 
     namespace {
         LazyValue<Float> d6500_cie_int{[]() -> Float { return get_cie_y_integral(CIE_D6500); }};
+
+        CMFWeights _compute_cmf_weights(const ISpectrum &light, Float cieyint)
+        {
+            auto weights = std::make_shared<std::vector<vec3>>();
+            weights->reserve(CURVES_ARRAY_LEN);
+
+            unsigned idx = 0u;
+            for(int lambda = WAVELENGHTS_START; lambda <= WAVELENGHTS_END; lambda += WAVELENGHTS_STEP, ++idx) {
+                weights->push_back(vec3{X_CURVE[idx], Y_CURVE[idx], Z_CURVE[idx]} * (light.get_or_interpolate(lambda) / cieyint));
+            }
+            return weights;
+        }
     }
 
     Float get_cie_y_integral()
@@ -31,23 +44,29 @@ namespace spec::util {
         return val;
     }
 
-    BasicSpectrum convert_to_spd(const ISpectrum &spectrum, const std::vector<Float> &wavelenghts)
+    CMFWeights compute_cmf_weights(const ISpectrum &light)
     {
-        BasicSpectrum spec;
-        if(wavelenghts.empty()) {
-            for(int i = WAVELENGHTS_START; i <= WAVELENGHTS_END; i += WAVELENGHTS_STEP) {
-                spec.set(Float(i), spectrum(Float(i)));
-            }
+        if(&light == &CIE_D6500) {
+            static const CMFWeights d6500_weights = _compute_cmf_weights(CIE_D6500, get_cie_y_integral());
+            return d6500_weights;
         }
-        else {
-            for(Float v : wavelenghts) {
-                spec.set(v, spectrum(v));
-            }
+        return _compute_cmf_weights(light, get_cie_y_integral(light));
+    }
+
+    SampledSpectrum convert_to_spd(const ISpectrum &spectrum, const std::vector<Float> &wavelenghts)
+    {
+        if(wavelenghts.empty()) {
+            std::vector<Float> values((WAVELENGHTS_END - WAVELENGHTS_START) / WAVELENGHTS_STEP + 1);
+            spectrum.sample_into(WAVELENGHTS_START, WAVELENGHTS_STEP, values.size(), values.data());
+            return SampledSpectrum(WAVELENGHTS_START, WAVELENGHTS_STEP, values);
         }
-        return spec;
+
+        std::vector<Float> values(wavelenghts.size());
+        spectrum.sample_into(wavelenghts.data(), wavelenghts.size(), values.data());
+        return SampledSpectrum(wavelenghts, values);
     }
 
-    const BasicSpectrum CIE_D6500{
+    const SampledSpectrum CIE_D6500{
         {300.000000f, 0.034100f}, 
         {305.000000f, 1.664300f},
         {310.000000f, 3.294500f},
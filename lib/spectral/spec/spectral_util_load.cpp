@@ -4,6 +4,8 @@
 #include <internal/serialization/envi.h>
 #include <internal/serialization/binary.h>
 #include <internal/common/format.h>
+#include <internal/common/mapped_file.h>
+#include <internal/common/util.h>
 #include <stb_image.h>
 #include <fstream>
 #include <stdexcept>
@@ -16,7 +18,7 @@
 
 #include <cstring>
 
-#include <internal/common/util.h>
+#include <internal/common/progress.h>
 
 using namespace spec;
 namespace fs = std::filesystem;
@@ -31,13 +33,14 @@ namespace spec::util
         }
     }
 
-    BasicSpectrum load_spd(const std::string &path)
+    SampledSpectrum load_spd(const std::string &path)
     {
         std::ifstream file{path};
         if(!file) throw std::runtime_error("Cannot open file");
-        BasicSpectrum sp;
+        SampledSpectrum sp;
 
         std::vector<std::tuple<Float, Float>> loaded = csv::load_as_vector<Float, Float>(file, ' ');
+        sp.reserve(loaded.size());
         for(const auto &p : loaded) {
             sp.set(std::get<0>(p), std::get<1>(p));
         }
@@ -45,7 +48,7 @@ namespace spec::util
         return sp;
     }
 
-    BasicSpectrum load_spd(const std::string &path, ISpectrum::csptr &lightsource)
+    SampledSpectrum load_spd(const std::string &path, ISpectrum::csptr &lightsource)
     {
         _d6500ptr(lightsource);
         return load_spd(path);
@@ -99,7 +102,7 @@ namespace spec::util
             return data;
         }
 
-        void _load_from_file(const fs::path &directory, const Metadata &meta, const MetadataEntry &entry, BasicSpectralImage &img)
+        void _load_from_file(const fs::path &directory, const Metadata &meta, const MetadataEntry &entry, DenseSpectralImage &img)
         {
             std::ifstream file{directory / entry.filename, std::ios::binary | std::ios::in};
             int w, h;
@@ -110,14 +113,16 @@ namespace spec::util
 
             const unsigned char *ptr = data.get();
             const int wl_count = entry.targets.size();
+            std::vector<int> bands(wl_count);
+            for(int k = 0; k < wl_count; ++k) {
+                bands[k] = img.find_band(entry.targets[k]);
+            }
 
-            for(int j = 0; j < meta.height; ++j) {
-                for(int i = 0; i < meta.width; ++i) {
-                    BasicSpectrum &spec = img.at(i, j);
-                    for(int k = 0; k < wl_count; ++k) {
-                        const Float val = std::fma<Float>(*(ptr++) / 255.0f, entry.norm_range, entry.norm_min_val); 
-                        spec.set(entry.targets[k], val);
-                    }
+            img.invalidate_statistics();
+            const long size = long(meta.width) * meta.height;
+            for(long i = 0; i < size; ++i) {
+                for(int k = 0; k < wl_count; ++k) {
+                    img.value(i, bands[k]) = std::fma<Float>(*(ptr++) / 255.0f, entry.norm_range, entry.norm_min_val); 
                 }
             }
 
@@ -126,7 +131,7 @@ namespace spec::util
     }
 
 
-    BasicSpectralImage load_json_meta(const std::string &meta_path, ISpectrum::csptr &lightsource)
+    DenseSpectralImage load_json_meta(const std::string &meta_path, ISpectrum::csptr &lightsource)
     {
         fs::path p{meta_path};
         std::ifstream meta_file{meta_path};
@@ -137,139 +142,167 @@ namespace spec::util
             throw std::runtime_error("Unsupported image format");
         }
 
-        BasicSpectralImage image{meta.width, meta.height};
-
-
+        std::vector<Float> wavelenghts;
         for(const MetadataEntry &entry : meta.wavelenghts) {
-            if(entry.targets.size() < 1 && entry.targets.size() > 4) {
+            if(entry.targets.size() < 1 || entry.targets.size() > 4) {
                 throw std::runtime_error("Too many wavelenghts per image");
             }
+            wavelenghts.insert(wavelenghts.end(), entry.targets.begin(), entry.targets.end());
+        }
+
+        //png1 stores every band in separate file
+        DenseSpectralImage image{meta.width, meta.height, wavelenghts, DenseSpectralImage::Layout::BAND_INTERLEAVED};
+
+        for(const MetadataEntry &entry : meta.wavelenghts) {
             _load_from_file(p.parent_path(), meta, entry, image);
         }
 
-        lightsource.reset(new BasicSpectrum(load_spd(p.parent_path() / "light.spd")));
+        lightsource.reset(new SampledSpectrum(load_spd(p.parent_path() / "light.spd")));
 
         return image;
     }
 
     namespace {
 
+        /**
+         *  Copies count values from (possibly unaligned) src, fixes byte order and stores them to dst with given stride.
+         */
         template<typename T>
-        void _load_bsq(const MetaENVI &meta, std::istream &str, BasicSpectralImage &img)
-        {   
-            init_progress_bar(meta.bands * meta.lines * meta.samples, 1000);
+        inline void _decode_run(const char *src, long count, bool swap, std::vector<T> &buf, Float *dst, long dst_stride)
+        {
+            buf.resize(count);
+            std::memcpy(buf.data(), src, count * sizeof(T));
+            if(swap) {
+                spec::swap_bytes(reinterpret_cast<char *>(buf.data()), count, sizeof(T));
+            }
+            for(long i = 0; i < count; ++i) {
+                dst[i * dst_stride] = static_cast<Float>(buf[i]);
+            }
+        }
 
-            size_t count = 0;
-            for(int w = 0; w < meta.bands; ++w) {
-                Float wl = meta.wavelength[w];
-                img.add_wavelenght(wl);
-                for(int j = 0; j < meta.lines; ++j) {
-                    for(int i = 0; i < meta.samples; ++i) {
-                        Float value = binary::read_ordered<T>(str, meta.byte_order == MetaENVI::ByteOrder::BIG_ENDIAN_ORDER);
-                        img.at(i, j).set(wl, value);
-                        print_progress(++count);
-                    }
+        //band-sequential and band-interleaved files consist of runs of one band over one line
+        template<typename T>
+        void _load_band_runs(const MetaENVI &meta, const char *src, bool swap, const std::vector<int> &bands, DenseSpectralImage &img)
+        {
+            const long runs = long(meta.lines) * meta.bands;
+            const long pixel_stride = img.get_pixel_stride();
+            const long band_stride = img.get_band_stride();
+            const bool bsq = meta.interleave == MetaENVI::Interleave::BSQ;
+            Float *dst = img.raw_data();
+
+            Progress progress{size_t(runs)};
+            #pragma omp parallel
+            {
+                std::vector<T> buf;
+                #pragma omp for schedule(static)
+                for(long r = 0; r < runs; ++r) {
+                    const long j = bsq ? r % meta.lines : r / meta.bands;
+                    const long b = bsq ? r / meta.lines : r % meta.bands;
+                    Float *line = dst + j * meta.samples * pixel_stride + bands[b] * band_stride;
+                    _decode_run<T>(src + r * meta.samples * sizeof(T), meta.samples, swap, buf, line, pixel_stride);
+                    progress.add();
                 }
-
             }
-            finish_progress_bar();
-
+            progress.finish();
         }
 
         template<typename T>
-        void _load_bil(const MetaENVI &meta, std::istream &str, BasicSpectralImage &img)
+        void _load_bip(const MetaENVI &meta, const char *src, bool swap, const std::vector<int> &bands, DenseSpectralImage &img)
         {
-            for(Float wl : meta.wavelength) {
-                img.add_wavelenght(wl);
+            const long line_size = long(meta.samples) * meta.bands;
+            //all bands of a pixel go to one spectrum, order of bands differs only if wavelenghts in header aren't sorted
+            bool sorted = true;
+            for(int b = 0; b < meta.bands; ++b) {
+                sorted = sorted && bands[b] == b;
+            }
+
+            Float *dst = img.raw_data();
+            const long pixel_stride = img.get_pixel_stride();
+            const long band_stride = img.get_band_stride();
+
+            Progress progress{size_t(meta.lines)};
+            #pragma omp parallel
+            {
+                std::vector<T> buf;
+                std::vector<Float> line(sorted ? 0 : line_size);
+                #pragma omp for schedule(static)
                 for(int j = 0; j < meta.lines; ++j) {
-                    for(int i = 0; i < meta.samples; ++i) {
-                        Float value = binary::read_ordered<T>(str, meta.byte_order == MetaENVI::ByteOrder::BIG_ENDIAN_ORDER);
-                        img.at(i, j).set(wl, value);
+                    const long offset = j * line_size;
+                    if(sorted) {
+                        _decode_run<T>(src + offset * sizeof(T), line_size, swap, buf, dst + offset, 1);
+                    }
+                    else {
+                        _decode_run<T>(src + offset * sizeof(T), line_size, swap, buf, line.data(), 1);
+                        for(int i = 0; i < meta.samples; ++i) {
+                            for(int b = 0; b < meta.bands; ++b) {
+                                dst[(i + long(j) * meta.samples) * pixel_stride + bands[b] * band_stride] = line[long(i) * meta.bands + b];
+                            }
+                        }
                     }
+                    progress.add();
                 }
-
             }
+            progress.finish();
         }
 
         template<typename T>
-        void _load_bip(const MetaENVI &meta, std::istream &str, BasicSpectralImage &img)
+        void _load_envi(const MetaENVI &meta, const MappedFile &file, const std::vector<int> &bands, DenseSpectralImage &img)
         {
-            for(int j = 0; j < meta.lines; ++j) {
-                for(Float wl : meta.wavelength) {
-                    for(int i = 0; i < meta.samples; ++i) {
-                        Float value = binary::read_ordered<T>(str, meta.byte_order == MetaENVI::ByteOrder::BIG_ENDIAN_ORDER);
-                        img.at(i, j).set(wl, value);
-                    }
-                }
-            }
-            for(Float wl : meta.wavelength) {
-                img.add_wavelenght(wl);
+            const size_t size = size_t(meta.samples) * meta.lines * meta.bands * sizeof(T);
+            if(file.size() < meta.header_offset || file.size() - meta.header_offset < size) {
+                throw std::runtime_error("Raw file is smaller than specified in header");
             }
 
+            const char *src = file.data() + meta.header_offset;
+            const bool swap = is_little_endian() == (meta.byte_order == MetaENVI::ByteOrder::BIG_ENDIAN_ORDER);
+            if(meta.interleave == MetaENVI::Interleave::BIP) {
+                _load_bip<T>(meta, src, swap, bands, img);
+            }
+            else {
+                _load_band_runs<T>(meta, src, swap, bands, img);
+            }
         }
 
-
     }
 
-    BasicSpectralImage load_envi_hdr(const std::string &meta_path, const std::string &raw_path, ISpectrum::csptr &lightsource)
+    DenseSpectralImage load_envi_hdr(const std::string &meta_path, const std::string &raw_path, ISpectrum::csptr &lightsource)
     {
         MetaENVI meta = MetaENVI::load(meta_path);
 
-        //meta.byte_order = MetaENVI::ByteOrder::LITTLE_ENDIAN_ORDER;
-
         std::cout << meta_path << " " << raw_path << std::endl;
 
         if(meta.wavelength_units == MetaENVI::UnitType::UNSUPPORTED || meta.data_type == MetaENVI::DataType::UNSUPPORTED) {
             throw std::runtime_error("Unsupported file format");
         }
-        std::ifstream file{raw_path, std::ios::in | std::ios::binary};
-        file.ignore(meta.header_offset); //Skip header offset specified in metadata
+        if(meta.wavelength.size() != size_t(meta.bands)) {
+            throw std::runtime_error("Number of wavelenghts doesn't match number of bands");
+        }
+        const MappedFile file{raw_path};
 
-        std::cout << "Loading file with width " << meta.lines << " height " << meta.samples << std::endl;
+        std::cout << "Loading file with width " << meta.samples << " height " << meta.lines << std::endl;
 
-        BasicSpectralImage img{meta.lines, meta.samples};
-        BasicSpectrum *raw_ptr = img.raw_data();
-        for(long i = 0; i < img.get_width() * img.get_height(); ++i) {
-            raw_ptr[i].reserve(meta.bands);
-        }
+        //keep band-sequential files in the same layout so that every band is one contiguous block
+        const auto layout = meta.interleave == MetaENVI::Interleave::BSQ ? DenseSpectralImage::Layout::BAND_INTERLEAVED : DenseSpectralImage::Layout::PIXEL_INTERLEAVED;
+        DenseSpectralImage img{meta.samples, meta.lines, meta.wavelength, layout};
 
-        switch(meta.interleave) {
-        case MetaENVI::Interleave::BSQ:
-            if(meta.data_type == MetaENVI::DataType::FLOAT32) {
-                _load_bsq<float>(meta, file, img);
-            }
-            else {
-                _load_bsq<double>(meta, file, img);
-            }
-            break;
-        case MetaENVI::Interleave::BIL:
-            if(meta.data_type == MetaENVI::DataType::FLOAT32) {
-                _load_bil<float>(meta, file, img);
-            }
-            else {
-                _load_bil<double>(meta, file, img);
-            }
-            break;
-        case MetaENVI::Interleave::BIP:
-            if(meta.data_type == MetaENVI::DataType::FLOAT32) {
-                _load_bip<float>(meta, file, img);
-            }
-            else {
-                _load_bip<double>(meta, file, img);
-            }
-            break;
+        std::vector<int> bands(meta.bands);
+        for(int b = 0; b < meta.bands; ++b) {
+            bands[b] = img.find_band(meta.wavelength[b]);
         }
 
-        BasicSpectrum *ls = new BasicSpectrum();
-
-        for(int w = 0; w < meta.bands; ++w) {
-            ls->set(meta.wavelength[w], Float(meta.illuminant[w]));
+        if(meta.data_type == MetaENVI::DataType::FLOAT32) {
+            _load_envi<float>(meta, file, bands, img);
         }
-        lightsource.reset(ls);
+        else {
+            _load_envi<double>(meta, file, bands, img);
+        }
+
+        const std::vector<Float> &light_wavelenghts = meta.illuminant_wavelength.empty() ? meta.wavelength : meta.illuminant_wavelength;
+        lightsource.reset(new SampledSpectrum(light_wavelenghts, meta.illuminant));
         return img;
     }
 
-    BasicSpectralImage load_envi_hdr(const std::string &meta_path, ISpectrum::csptr &lightsource)
+    DenseSpectralImage load_envi_hdr(const std::string &meta_path, ISpectrum::csptr &lightsource)
     {
         fs::path p{meta_path};
         return load_envi_hdr(meta_path, p.replace_extension("raw").string(), lightsource);
@@ -292,7 +325,7 @@ namespace spec::util
 
     SigPolySpectralImage load_sigpoly_img(const std::string &path, ISpectrum::csptr &lightsource)
     {
-        std::ifstream file{path};
+        std::ifstream file{path, std::ios::in | std::ios::binary};
         if(!file) throw std::runtime_error("Cannot open file");
 
         const uint64_t marker = binary::read<uint64_t>(file);
@@ -305,8 +338,12 @@ namespace spec::util
         SigPolySpectralImage img{int(width), int(height)};
         auto *ptr = img.raw_data();
 
-        for(uint32_t i = 0; i < width * height; ++i) {
-            ptr[i].set(binary::read_vec<Float>(file));
+        const size_t size = size_t(width) * height;
+        std::vector<Float> coefs(size * 3);
+        binary::read_array<Float>(file, coefs.data(), coefs.size());
+        if(!file) throw std::runtime_error("Error reading data");
+        for(size_t i = 0; i < size; ++i) {
+            ptr[i].set({coefs[i * 3], coefs[i * 3 + 1], coefs[i * 3 + 2]});
         }
 
         _d6500ptr(lightsource);
@@ -370,7 +407,7 @@ namespace spec::util
             s.reset(new SigPolySpectrum(load_sigpoly(path, lightsource)));
             return true;
         case SpectrumFormat::BASIC_SPD:
-            s.reset(new BasicSpectrum(load_spd(path, lightsource)));
+            s.reset(new SampledSpectrum(load_spd(path, lightsource)));
             return true;
         default:
             return false;
@@ -388,10 +425,10 @@ namespace spec::util
                 img.reset(new SigPolySpectralImage(load_sigpoly_img(path, lightsource)));
                 return true;
             case SpectralImgFormat::BASIC_JSON:
-                img.reset(new BasicSpectralImage(load_json_meta(path, lightsource)));
+                img.reset(new DenseSpectralImage(load_json_meta(path, lightsource)));
                 return true;
             case SpectralImgFormat::BASIC_ENVI_HDR:
-                img.reset(new BasicSpectralImage(load_envi_hdr(path, lightsource)));
+                img.reset(new DenseSpectralImage(load_envi_hdr(path, lightsource)));
                 return true;
             default:
                 return false;
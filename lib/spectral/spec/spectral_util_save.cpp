@@ -1,10 +1,14 @@
 #include <spec/spectral_util.h>
+#include <spec/fourier_spectrum.h>
 #include <internal/serialization/binary.h>
 #include <internal/common/constants.h>
 #include <internal/common/refl.h>
 #include <internal/common/format.h>
 #include <fstream>
 #include <stdexcept>
+#include <algorithm>
+#include <atomic>
+#include <cmath>
 #include <memory>
 #include <limits>
 #include <filesystem>
@@ -32,21 +36,22 @@ namespace
         return stbi_write_png_to_func(_to_stream, reinterpret_cast<void *>(&stream), width, height, channels, buf, 0);
     }
 
+    /**
+     *  Normalization range is taken from cached band statistics, so values are looked up only once.
+     */
     void normalize_and_convert_to_rgb(const BasicSpectralImage &img, unsigned char *dst, const std::vector<Float> &wavelenghts, int channels, Float &range_out, Float &min_val_out)
     {
+        const long size = long(img.get_height()) * img.get_width();
+        const int vector_size = wavelenghts.size();
+        const BandStatistics::ptr stats = img.get_band_statistics();
 
-        //calculate normalization data
         Float min_val = std::numeric_limits<Float>::max();
-        Float max_val = std::numeric_limits<Float>::min();
-
-        const BasicSpectrum *ptr;
-        const BasicSpectrum *end = img.raw_data() + img.get_height() * img.get_width();
-        for(ptr = img.raw_data(); ptr < end; ++ptr) {
-            for(Float w : wavelenghts) {
-                Float val = (*ptr)[w];
-                if(val > max_val) max_val = val; 
-                if(val < min_val) min_val = val;
-            }
+        Float max_val = std::numeric_limits<Float>::lowest();
+        for(Float w : wavelenghts) {
+            const int b = stats->find_band(w);
+            if(b < 0) throw std::runtime_error("No values at requested wavelenght");
+            min_val = std::min(min_val, stats->min[b]);
+            max_val = std::max(max_val, stats->max[b]);
         }
 
         Float range = max_val - min_val;
@@ -54,17 +59,14 @@ namespace
             range = 1.0f;
         }
 
-
-        const BasicSpectrum *data = img.raw_data();
         //normalize and write to rgb buffer
-        const int vector_size = wavelenghts.size();
-        for(long i = 0; i < img.get_height() * img.get_width(); ++i) {
+        const BasicSpectrum *data = img.raw_data();
+        for(long i = 0; i < size; ++i) {
             for(int c = 0; c < vector_size; ++c) {
-                Float w = data[i][wavelenghts[c]];
-                Float w_norm = (w - min_val) / range;
+                Float w_norm = (data[i][wavelenghts[c]] - min_val) / range;
                 dst[i * channels + c] = static_cast<unsigned char>(w_norm * 255.999f);
             }
-            for(int c = wavelenghts.size(); c < channels; ++c) {
+            for(int c = vector_size; c < channels; ++c) {
                 dst[i * channels + c] = 0; //zero additional channels
             }
         }
@@ -72,6 +74,25 @@ namespace
         range_out = range;
         min_val_out = min_val;
     }
+
+    void normalize_band_to_gray(const DenseSpectralImage &img, const BandStatistics &stats, int band, unsigned char *dst, Float &range_out, Float &min_val_out)
+    {
+        const long size = long(img.get_width()) * img.get_height();
+        const Float min_val = stats.min[band];
+
+        Float range = stats.max[band] - min_val;
+        if(range < 1.0f) {
+            range = 1.0f;
+        }
+
+        for(long i = 0; i < size; ++i) {
+            Float w_norm = (img.value(i, band) - min_val) / range;
+            dst[i] = static_cast<unsigned char>(w_norm * 255.999f);
+        }
+
+        range_out = range;
+        min_val_out = min_val;
+    }
 }
 
 using json = nlohmann::json;
@@ -83,6 +104,111 @@ namespace spec
 
         const std::string META_FILENAME = "meta.json";
 
+        namespace {
+            bool save_light(const std::string &path, const ISpectrum &lightsource)
+            {
+                if(isa<SampledSpectrum>(lightsource)) {
+                    save_spd(path, static_cast<const SampledSpectrum &>(lightsource));
+                    return true;
+                }
+                if(isa<BasicSpectrum>(lightsource)) {
+                    save_spd(path, static_cast<const BasicSpectrum &>(lightsource));
+                    return true;
+                }
+                return false;
+            }
+
+            /**
+             *  Own samples of sampled lights, other lights are sampled on CIE wavelenghts.
+             */
+            void _light_samples(const ISpectrum &lightsource, std::vector<Float> &wavelenghts, std::vector<Float> &values)
+            {
+                if(isa<SampledSpectrum>(lightsource)) {
+                    for(const auto &[w, val] : static_cast<const SampledSpectrum &>(lightsource).get_samples()) {
+                        wavelenghts.push_back(w);
+                        values.push_back(val);
+                    }
+                }
+                else if(isa<BasicSpectrum>(lightsource)) {
+                    const BasicSpectrum &basic = static_cast<const BasicSpectrum &>(lightsource);
+                    for(Float w : basic.get_wavelenghts()) {
+                        wavelenghts.push_back(w);
+                        values.push_back(basic.get_map().at(w));
+                    }
+                }
+                else {
+                    const size_t count = (WAVELENGHTS_END - WAVELENGHTS_START) / WAVELENGHTS_STEP + 1;
+                    values.resize(count);
+                    lightsource.sample_into(WAVELENGHTS_START, WAVELENGHTS_STEP, count, values.data());
+                    for(size_t i = 0; i < count; ++i) {
+                        wavelenghts.push_back(WAVELENGHTS_START + Float(i * WAVELENGHTS_STEP));
+                    }
+                }
+            }
+
+            std::ofstream _begin_envi(int width, int height, const std::vector<Float> &wavelenghts, const std::string &meta_path, const std::string &raw_path,
+                                      MetaENVI::Interleave interleave, MetaENVI::ByteOrder byte_order, const ISpectrum &lightsource)
+            {
+                MetaENVI meta;
+                meta.samples = width;
+                meta.lines = height;
+                meta.bands = wavelenghts.size();
+                meta.byte_order = byte_order;
+                meta.data_type = MetaENVI::DataType::FLOAT32;
+                meta.interleave = interleave;
+                meta.wavelength = wavelenghts;
+                _light_samples(lightsource, meta.illuminant_wavelength, meta.illuminant);
+                meta.save(meta_path);
+
+                std::ofstream file{raw_path, std::ios::out | std::ios::binary | std::ios::trunc};
+                if(!file) throw std::runtime_error("Cannot open file");
+                return file;
+            }
+
+            /**
+             *  Gathers values in file order one band (BSQ) or one line (BIL, BIP) at a time.
+             */
+            template<typename ValueFn>
+            void _write_envi_raw(std::ostream &file, int width, int height, int bands, MetaENVI::Interleave interleave, bool big_endian, ValueFn value)
+            {
+                const long size = long(width) * height;
+                std::vector<float> buf;
+                switch(interleave) {
+                case MetaENVI::Interleave::BSQ:
+                    buf.resize(size);
+                    for(int b = 0; b < bands; ++b) {
+                        for(long i = 0; i < size; ++i) {
+                            buf[i] = value(i, b);
+                        }
+                        binary::write_array_ordered<float>(file, buf.data(), buf.size(), big_endian);
+                    }
+                    break;
+                case MetaENVI::Interleave::BIL:
+                    buf.resize(long(width) * bands);
+                    for(int j = 0; j < height; ++j) {
+                        for(int b = 0; b < bands; ++b) {
+                            for(int i = 0; i < width; ++i) {
+                                buf[long(b) * width + i] = value(i + long(j) * width, b);
+                            }
+                        }
+                        binary::write_array_ordered<float>(file, buf.data(), buf.size(), big_endian);
+                    }
+                    break;
+                case MetaENVI::Interleave::BIP:
+                    buf.resize(long(width) * bands);
+                    for(int j = 0; j < height; ++j) {
+                        for(int i = 0; i < width; ++i) {
+                            for(int b = 0; b < bands; ++b) {
+                                buf[long(i) * bands + b] = value(i + long(j) * width, b);
+                            }
+                        }
+                        binary::write_array_ordered<float>(file, buf.data(), buf.size(), big_endian);
+                    }
+                    break;
+                }
+            }
+        }
+
         void Metadata::save(std::ostream &stream) const
         {
             json meta;
@@ -156,6 +282,18 @@ namespace spec
             file.flush();
         }
 
+        void save_spd(const std::string &path, const SampledSpectrum &spectre)
+        {
+            std::ofstream file(path, std::ios::trunc);
+            if(!file) throw std::runtime_error("Cannot open file");
+
+            for(const auto &[wl, value] : spectre.get_samples()) {
+                file << format(SPD_OUTPUT_FORMAT, wl, value);
+            }
+
+            file.flush();
+        }
+
         void save_wavelenghts_to_png_multichannel(std::ostream &stream, const BasicSpectralImage &img, const std::vector<Float> &wavelenghts, SavingResult &res, int requested_channels)
         {
             const int vector_size = wavelenghts.size();
@@ -205,27 +343,32 @@ namespace spec
             const fs::path dir_path{dir};
             fs::create_directories(dir_path);
             
-            if(!isa<BasicSpectrum>(lightsource)) return false;
-
+            if(!save_light(dir_path / "light.spd", lightsource)) return false;
 
-            save_spd(dir_path / "light.spd", static_cast<const BasicSpectrum &>(lightsource));
+            //bands are encoded concurrently, metadata are kept in order of wavelenghts
+            const std::vector<Float> wavelenghts(image.get_wavelenghts().begin(), image.get_wavelenghts().end());
+            std::vector<MetadataEntry> entries(wavelenghts.size());
+            std::atomic<bool> failed{false};
+            image.get_band_statistics(); //computed once before bands are encoded
 
-            SavingResult saving_result;
-            for(Float w : image.get_wavelenghts()) {
+            #pragma omp parallel for schedule(dynamic)
+            for(long b = 0; b < long(wavelenghts.size()); ++b) {
+                if(failed.load(std::memory_order_relaxed)) continue;
                 //save as 1-channel png
+                const Float w = wavelenghts[b];
                 std::string filename = format(IMG_FILENAME_FORMAT, w);
-                fs::path img_path = dir_path / filename;
-                std::fstream file(img_path, std::ios::out | std::ios::binary | std::ios::trunc);
+                std::fstream file(dir_path / filename, std::ios::out | std::ios::binary | std::ios::trunc);
+                SavingResult saving_result;
                 try {
                     save_wavelenght_to_png1(file, image, w, saving_result);
                 } catch(...) {
-                    file.close();
-                    throw;
+                    failed = true;
                 }
-                //add entry to metadata
-                metadata.wavelenghts.push_back(MetadataEntry{filename, {w}, saving_result.norm_min, saving_result.norm_range});
-                file.close();
+                entries[b] = MetadataEntry{filename, {w}, saving_result.norm_min, saving_result.norm_range};
             }
+            if(failed) throw std::runtime_error("Error saving to file");
+            metadata.wavelenghts = std::move(entries);
+
             //save metadata
             std::fstream meta_file(dir_path / meta_filename, std::ios::out | std::ios::trunc);
             metadata.save(meta_file);
@@ -234,6 +377,168 @@ namespace spec
             return true;
         }
 
+        bool save_as_png1(const DenseSpectralImage &image, const std::string &dir, const std::string &meta_filename, const ISpectrum &lightsource) {
+
+            Metadata metadata;
+            metadata.width = image.get_width();
+            metadata.height = image.get_height();
+
+            metadata.format = "png1";
+
+            const fs::path dir_path{dir};
+            fs::create_directories(dir_path);
+            
+            if(!save_light(dir_path / "light.spd", lightsource)) return false;
+
+            const int width = image.get_width();
+            const int height = image.get_height();
+
+            //bands are encoded concurrently, metadata are kept in order of wavelenghts
+            const std::vector<Float> &wavelenghts = image.get_wavelenghts();
+            const BandStatistics::ptr stats = image.get_band_statistics();
+            std::vector<MetadataEntry> entries(wavelenghts.size());
+            std::atomic<bool> failed{false};
+
+            #pragma omp parallel
+            {
+                std::unique_ptr<unsigned char[]> buf{new unsigned char[long(width) * height]};
+
+                #pragma omp for schedule(dynamic)
+                for(int b = 0; b < int(wavelenghts.size()); ++b) {
+                    if(failed.load(std::memory_order_relaxed)) continue;
+                    std::string filename = format(IMG_FILENAME_FORMAT, wavelenghts[b]);
+                    std::fstream file(dir_path / filename, std::ios::out | std::ios::binary | std::ios::trunc);
+
+                    Float norm_range, norm_min;
+                    normalize_band_to_gray(image, *stats, b, buf.get(), norm_range, norm_min);
+                    if(!write_png_to_stream(file, width, height, 1, buf.get())) {
+                        failed = true;
+                    }
+                    entries[b] = MetadataEntry{filename, {wavelenghts[b]}, norm_min, norm_range};
+                }
+            }
+            if(failed) throw std::runtime_error("Error saving to file");
+            metadata.wavelenghts = std::move(entries);
+
+            std::fstream meta_file(dir_path / meta_filename, std::ios::out | std::ios::trunc);
+            metadata.save(meta_file);
+            meta_file.close();
+
+            return true;
+        }
+
+        bool parse_envi_format(const std::string &format, MetaENVI::Interleave &interleave, MetaENVI::ByteOrder &byte_order)
+        {
+            static const std::string BE_SUFFIX = "_be";
+            std::string base = format;
+            byte_order = MetaENVI::ByteOrder::LITTLE_ENDIAN_ORDER;
+            if(base.size() > BE_SUFFIX.size() && base.compare(base.size() - BE_SUFFIX.size(), BE_SUFFIX.size(), BE_SUFFIX) == 0) {
+                base.erase(base.size() - BE_SUFFIX.size());
+                byte_order = MetaENVI::ByteOrder::BIG_ENDIAN_ORDER;
+            }
+
+            if(base == "envi" || base == "envi_bsq") {
+                interleave = MetaENVI::Interleave::BSQ;
+            }
+            else if(base == "envi_bil") {
+                interleave = MetaENVI::Interleave::BIL;
+            }
+            else if(base == "envi_bip") {
+                interleave = MetaENVI::Interleave::BIP;
+            }
+            else return false;
+            return true;
+        }
+
+        bool save_envi_hdr(const DenseSpectralImage &image, const std::string &meta_path, const std::string &raw_path,
+                           MetaENVI::Interleave interleave, MetaENVI::ByteOrder byte_order, const ISpectrum &lightsource)
+        {
+            const std::vector<Float> &wavelenghts = image.get_wavelenghts();
+            std::ofstream file = _begin_envi(image.get_width(), image.get_height(), wavelenghts, meta_path, raw_path, interleave, byte_order, lightsource);
+            const bool big_endian = byte_order == MetaENVI::ByteOrder::BIG_ENDIAN_ORDER;
+            const long size = long(image.get_width()) * image.get_height();
+
+            //layouts matching the file are written without reordering
+            if(interleave == MetaENVI::Interleave::BSQ && image.get_pixel_stride() == 1) {
+                for(size_t b = 0; b < wavelenghts.size(); ++b) {
+                    binary::write_array_ordered<float>(file, image.raw_data() + b * image.get_band_stride(), size, big_endian);
+                }
+            }
+            else if(interleave == MetaENVI::Interleave::BIP && image.get_band_stride() == 1) {
+                binary::write_array_ordered<float>(file, image.raw_data(), size * wavelenghts.size(), big_endian);
+            }
+            else {
+                _write_envi_raw(file, image.get_width(), image.get_height(), wavelenghts.size(), interleave, big_endian,
+                                [&image](long pixel, int band) { return image.value(pixel, band); });
+            }
+            file.flush();
+            return bool(file);
+        }
+
+        bool save_envi_hdr(const BasicSpectralImage &image, const std::string &meta_path, const std::string &raw_path,
+                           MetaENVI::Interleave interleave, MetaENVI::ByteOrder byte_order, const ISpectrum &lightsource)
+        {
+            const std::vector<Float> wavelenghts(image.get_wavelenghts().begin(), image.get_wavelenghts().end());
+            std::ofstream file = _begin_envi(image.get_width(), image.get_height(), wavelenghts, meta_path, raw_path, interleave, byte_order, lightsource);
+            const BasicSpectrum *data = image.raw_data();
+            _write_envi_raw(file, image.get_width(), image.get_height(), wavelenghts.size(), interleave, byte_order == MetaENVI::ByteOrder::BIG_ENDIAN_ORDER,
+                            [data, &wavelenghts](long pixel, int band) { return data[pixel](wavelenghts[band]); });
+            file.flush();
+            return bool(file);
+        }
+
+        bool save_envi_hdr(const ISpectralImage &image, const std::string &meta_path, const std::string &raw_path,
+                           MetaENVI::Interleave interleave, MetaENVI::ByteOrder byte_order, const ISpectrum &lightsource)
+        {
+            require_precomputed(image);
+
+            const int width = image.get_width();
+            const int height = image.get_height();
+            const int bands = (WAVELENGHTS_END - WAVELENGHTS_START) / WAVELENGHTS_STEP + 1;
+            std::vector<Float> wavelenghts(bands);
+            for(int b = 0; b < bands; ++b) {
+                wavelenghts[b] = WAVELENGHTS_START + Float(b * WAVELENGHTS_STEP);
+            }
+            std::ofstream file = _begin_envi(width, height, wavelenghts, meta_path, raw_path, interleave, byte_order, lightsource);
+            const bool big_endian = byte_order == MetaENVI::ByteOrder::BIG_ENDIAN_ORDER;
+
+            //one line of pixels in BIP order, other interleaves are gathered from it
+            std::vector<Float> line(size_t(width) * bands);
+            std::vector<float> buf(interleave == MetaENVI::Interleave::BIP ? 0 : line.size());
+            for(int j = 0; j < height; ++j) {
+                #pragma omp parallel for
+                for(int i = 0; i < width; ++i) {
+                    image.at(i, j).sample_into(WAVELENGHTS_START, WAVELENGHTS_STEP, bands, line.data() + size_t(i) * bands);
+                }
+
+                switch(interleave) {
+                case MetaENVI::Interleave::BIP:
+                    binary::write_array_ordered<float>(file, line.data(), line.size(), big_endian);
+                    break;
+                case MetaENVI::Interleave::BIL:
+                    for(int b = 0; b < bands; ++b) {
+                        for(int i = 0; i < width; ++i) {
+                            buf[size_t(b) * width + i] = line[size_t(i) * bands + b];
+                        }
+                    }
+                    binary::write_array_ordered<float>(file, buf.data(), buf.size(), big_endian);
+                    break;
+                case MetaENVI::Interleave::BSQ:
+                    //line of every band goes to its own place in file
+                    for(int b = 0; b < bands; ++b) {
+                        for(int i = 0; i < width; ++i) {
+                            buf[i] = line[size_t(i) * bands + b];
+                        }
+                        file.seekp((std::streamoff(b) * height + j) * width * sizeof(float));
+                        binary::write_array_ordered<float>(file, buf.data(), width, big_endian);
+                    }
+                    break;
+                }
+            }
+            file.flush();
+            return bool(file);
+        }
+
         bool save_sigpoly(const std::string path, const SigPolySpectrum &spectrum)
         {
             std::ofstream file(path, std::ios::trunc);
@@ -247,10 +552,10 @@ namespace spec
         
         bool save_sigpoly_img(const std::string path, const SigPolySpectralImage &img)
         {
-            std::ofstream file(path, std::ios::trunc);
+            std::ofstream file(path, std::ios::trunc | std::ios::binary);
             if(!file) throw std::runtime_error("Cannot open file");
 
-            const unsigned size = img.get_height() * img.get_width();
+            const size_t size = size_t(img.get_height()) * img.get_width();
 
             //HEADER
             binary::write<uint64_t>(file, SIGPOLY_FILE_MARKER);
@@ -260,12 +565,17 @@ namespace spec
 
             //DATA
             const auto *ptr = img.raw_data();
-            for(unsigned i = 0; i < size; ++i) {
-                binary::write_vec<Float>(file, ptr[i].get());
+            std::vector<Float> coefs(size * 3);
+            for(size_t i = 0; i < size; ++i) {
+                const vec3 &c = ptr[i].get();
+                coefs[i * 3] = c.x;
+                coefs[i * 3 + 1] = c.y;
+                coefs[i * 3 + 2] = c.z;
             }
+            binary::write_array<Float>(file, coefs.data(), coefs.size());
 
             file.flush();
-            return false;
+            return bool(file);
         }
         
         bool save(const std::string &directory_path, const std::string &input_filename, const ISpectrum &s) {
@@ -275,23 +585,54 @@ namespace spec
                 save_spd(p / (input_filename + ".spd"), spectrum);
                 return true;
             }
+            if(isa<SampledSpectrum>(s)) {
+                const SampledSpectrum &spectrum = static_cast<const SampledSpectrum &>(s);
+                save_spd(p / (input_filename + ".spd"), spectrum);
+                return true;
+            }
             if(isa<SigPolySpectrum>(s)) {
                 const SigPolySpectrum &spectrum = static_cast<const SigPolySpectrum &>(s);
                 return save_sigpoly(p / (input_filename + ".spspec"), spectrum);
             }
+            if(isa<DenseSpectralImage::SpectrumType>(s)) {
+                const auto &spectrum = static_cast<const DenseSpectralImage::SpectrumType &>(s);
+                save_spd(p / (input_filename + ".spd"), convert_to_spd(spectrum, spectrum.get_image().get_wavelenghts()));
+                return true;
+            }
             return false;
         }
 
-        bool save(const std::string &directory_path, const std::string &input_filename, const ISpectralImage &s) {
+        bool save(const std::string &directory_path, const std::string &input_filename, const ISpectralImage &s, const std::string &format) {
             if(s.get_width() == 1 && s.get_height() == 1) {
                 return save(directory_path, input_filename, s.at(0, 0));
             }
             fs::path p{directory_path};
+            MetaENVI::Interleave interleave;
+            MetaENVI::ByteOrder byte_order;
+            if(parse_envi_format(format, interleave, byte_order)) {
+                fs::create_directories(p);
+                const std::string meta_path = p / (input_filename + ".hdr");
+                const std::string raw_path = p / (input_filename + ".raw");
+                if(isa<BasicSpectralImage>(s)) {
+                    return save_envi_hdr(static_cast<const BasicSpectralImage &>(s), meta_path, raw_path, interleave, byte_order);
+                }
+                if(isa<DenseSpectralImage>(s)) {
+                    return save_envi_hdr(static_cast<const DenseSpectralImage &>(s), meta_path, raw_path, interleave, byte_order);
+                }
+                return save_envi_hdr(s, meta_path, raw_path, interleave, byte_order);
+            }
+            if(!format.empty() && format != "png1") {
+                return false;
+            }
             if(isa<BasicSpectralImage>(s)) {
                 const BasicSpectralImage &img = static_cast<const BasicSpectralImage &>(s);
                 return save_as_png1(img, p / input_filename);
                 
             }
+            if(isa<DenseSpectralImage>(s)) {
+                const DenseSpectralImage &img = static_cast<const DenseSpectralImage &>(s);
+                return save_as_png1(img, p / input_filename);
+            }
             if(isa<SigPolySpectralImage>(s)) {
                 const SigPolySpectralImage &img = static_cast<const SigPolySpectralImage &>(s);
                 return save_sigpoly_img(p / (input_filename + ".sif"), img);
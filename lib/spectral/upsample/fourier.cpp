@@ -1,57 +1,84 @@
 #include <upsample/fourier.h>
 #include <upsample/functional/fourier.h>
-#include <internal/common/util.h>
-#include <fstream>
+#include <internal/common/progress.h>
+#include <stdexcept>
+#include <algorithm>
 
 namespace spec {
 
     namespace {
 
-        FourierLUT load_from_file(const std::string &path)
+        inline void require_emission(bool emiss)
         {
-            std::ifstream file{path};
-            return FourierLUT::load_from(file);
+            if(!emiss) throw std::runtime_error("Reflectance fourier upsampling is not supported");
         }
 
     }
 
-    FourierUpsampler::FourierUpsampler(bool emiss)
-        : lut{load_from_file("resources/f_emission_lut.efif")}, emiss{emiss}
+    FourierUpsampler::FourierUpsampler(bool emiss, Float power)
+        : lut{FourierLUT::load_from_file("resources/f_emission_lut.eflf")}, emiss{emiss}, power{power}
     {
 
     }
 
     ISpectrum::ptr FourierUpsampler::upsample_pixel(const Pixel &src) const
     {
-        if(emiss) {
-            return ISpectrum::ptr(new FourierEmissionSpectrum(upsample::fourier_emiss_int(src, lut)));
-        }
-        else {
-            return {}; //TODO
+        require_emission(emiss);
+
+        return ISpectrum::ptr(new FourierEmissionSpectrum(upsample::fourier_emiss_int(src, power, lut)));
+    }
+
+    unsigned FourierUpsampler::get_batch_stride() const
+    {
+        return lut.get_m() + 1;
+    }
+
+    void FourierUpsampler::upsample_batch(const Pixel *src, size_t count, Float *dst) const
+    {
+        require_emission(emiss);
+
+        upsample::fourier_emiss_int(src, count, power, lut, dst);
+    }
+
+    void FourierUpsampler::upsample_batch(const vec3 *src, size_t count, Float *dst) const
+    {
+        require_emission(emiss);
+
+        constexpr size_t CHUNK = 256;
+        Pixel pixels[CHUNK];
+        const unsigned stride = get_batch_stride();
+        for(size_t start = 0; start < count; start += CHUNK) {
+            const size_t n = std::min(CHUNK, count - start);
+            for(size_t i = 0; i < n; ++i) {
+                pixels[i] = Pixel::from_vec3(src[start + i]);
+            }
+            upsample::fourier_emiss_int(pixels, n, power, lut, dst + start * stride);
         }
     }
 
     ISpectralImage::ptr FourierUpsampler::upsample(const Image &sourceImage) const
-    {   
-        if(emiss) {
-            FourierEmissionSpectralImage *dest = new FourierEmissionSpectralImage(sourceImage.get_width(), sourceImage.get_height());
-           
-            const long img_size = sourceImage.get_width() * sourceImage.get_height();
-            init_progress_bar(img_size, 1000);
-
-            const Pixel *ptr = sourceImage.raw_data();
-            FourierEmissionSpectrum *s_ptr = dest->raw_data();
-            for(int i = 0; i < img_size; ++i) {
-                s_ptr[i] = upsample::fourier_emiss_int(ptr[i], luts);
-                print_progress(i + 1);
-            }
+    {
+        require_emission(emiss);
 
-            finish_progress_bar();
-            return ISpectralImage::ptr(dest);
-        }
-        else {
-            return {}; //TODO
+        const int width = sourceImage.get_width();
+        const int height = sourceImage.get_height();
+        const unsigned stride = get_batch_stride();
+        FourierEmissionSpectralImage *dest = new FourierEmissionSpectralImage(width, height, lut.get_m());
+        Progress progress{size_t(width) * height};
+
+        //coefficients are written directly to flat image, one row per batch
+        const Pixel *ptr = sourceImage.raw_data();
+        Float *coef = dest->raw_data();
+        #pragma omp parallel for
+        for(int j = 0; j < height; ++j) {
+            const long offset = long(j) * width;
+            upsample::fourier_emiss_int(ptr + offset, width, power, lut, coef + offset * stride);
+            progress.add(width);
         }
+
+        progress.finish();
+        dest->precompute();
+        return ISpectralImage::ptr(dest);
     }
 
-}
\ No newline at end of file
+}
@@ -1,23 +1,65 @@
 #include <upsample/functional/fourier.h>
-#include <iostream>
+#include <algorithm>
 
 namespace spec::upsample {
+
+    namespace {
+
+        //pixels are normalized in chunks on stack before evaluation
+        constexpr size_t BATCH_CHUNK = 256;
+
+        bool normalize(const Pixel &pixel, Float &power, vec3i &rgbi)
+        {
+            vec3 rgb = pixel.to_vec3();
+            Float max = rgb.max();
+            if(max == 0.0f) return false;
+            if(max < 1.0f) {
+                rgb = math::clamp(rgb / max, 0.0f, 1.0f);
+                power *= max;
+            }
+            rgbi = (rgb * 255.0f).cast<int>();
+            return true;
+        }
+
+    }
+
+    void fourier_emiss_int(const Pixel &pixel, Float power, const FourierLUT &lut, Float *dst)
+    {
+        vec3i rgbi;
+        if(!normalize(pixel, power, rgbi)) {
+            std::fill(dst, dst + lut.get_m() + 1, 0.0f);
+            return;
+        }
+
+        lut.eval(rgbi.x, rgbi.y, rgbi.z, power, dst);
+    }
+
+    void fourier_emiss_int(const Pixel *pixels, size_t count, Float power, const FourierLUT &lut, Float *dst)
+    {
+        const unsigned stride = lut.get_m() + 1;
+        vec3i rgbi[BATCH_CHUNK];
+        Float powers[BATCH_CHUNK];
+
+        for(size_t start = 0; start < count; start += BATCH_CHUNK) {
+            const size_t n = std::min(BATCH_CHUNK, count - start);
+            for(size_t i = 0; i < n; ++i) {
+                powers[i] = power;
+                if(!normalize(pixels[start + i], powers[i], rgbi[i])) {
+                    rgbi[i] = vec3i{-1, -1, -1}; //black pixel, evaluated to zeros
+                }
+            }
+            lut.eval_batch(rgbi, powers, n, dst + start * stride);
+        }
+    }
     
     FourierEmissionSpectrum fourier_emiss_int(const Pixel &pixel, Float power, const FourierLUT &lut)
     {
-        vec3 rgb = pixel.to_vec3();
-        Float max = rgb.max();
-        if(max < 1.0f && max > 0.0f) {
-            rgb = math::clamp(rgb / max, 0.0f, 1.0f);
-            power *= max;
-        }
-        if(max == 0.0f) return FourierEmissionSpectrum{std::vector<Float>{0.0f}};
+        vec3i rgbi;
+        if(!normalize(pixel, power, rgbi)) return FourierEmissionSpectrum{std::vector<Float>{0.0f}};
 
-        vec3i rgbi = (rgb * 255.0f).cast<int>();
-        std::cout << "Evaluating " << rgbi << ", power " << power << std::endl;
         std::vector<Float> coeffs = lut.eval(rgbi.x, rgbi.y, rgbi.z, power);
 
         return FourierEmissionSpectrum{std::move(coeffs)};
     }
 
-}
\ No newline at end of file
+}
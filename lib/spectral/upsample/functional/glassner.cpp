@@ -1,6 +1,7 @@
 #include <upsample/functional/glassner.h>
 #include <spec/conversions.h>
 #include <internal/math/math.h>
+#include <vector>
 
 namespace spec::upsample {
 
@@ -12,23 +13,22 @@ namespace spec::upsample {
             0.348f, 0.023f, 1.747f
         });
 
-        void upsample_to(const vec3 &rgb, BasicSpectrum &spectrum)
-        {
-            vec3 ampls = math::clamp(rgb2xyz(rgb) * XYZ_TO_SPECTRE_INV, 0.0f, 1.0f);
-       
-            spectrum.get_or_create(GLASSNER_WAVELENGHTS[0]) = ampls[0];
-            spectrum.get_or_create(GLASSNER_WAVELENGHTS[1]) = ampls[1];
-            spectrum.get_or_create(GLASSNER_WAVELENGHTS[2]) = ampls[2];
-        }
-
     }
 
+    void glassner(const vec3 &rgb, Float *dst)
+    {
+        vec3 ampls = math::clamp(rgb2xyz(rgb) * XYZ_TO_SPECTRE_INV, 0.0f, 1.0f);
+
+        dst[0] = ampls[0];
+        dst[1] = ampls[1];
+        dst[2] = ampls[2];
+    }
 
-    BasicSpectrum glassner(const vec3 &rgb)
+    SampledSpectrum glassner(const vec3 &rgb)
     {
-        BasicSpectrum spectrum;
-        upsample_to(rgb, spectrum);
-        return spectrum;
+        std::vector<Float> values(GLASSNER_SPECTRUM_SIZE);
+        glassner(rgb, values.data());
+        return SampledSpectrum(std::vector<Float>(GLASSNER_WAVELENGHTS, GLASSNER_WAVELENGHTS + GLASSNER_SPECTRUM_SIZE), values);
     }
 
 }
\ No newline at end of file
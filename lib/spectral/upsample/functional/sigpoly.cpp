@@ -10,7 +10,7 @@ namespace spec::upsample {
             return p[m] >= p[2] ? m : 2;
         }
 
-        void upsample_to(const Pixel &pixel, SigPolySpectrum &s, const SigpolyLUT lut[3])
+        vec3 upsample_to(const Pixel &pixel, const SigpolyLUT lut[3])
         {
             int amax = argmax(pixel);
             int a = 0, b = 0;
@@ -21,16 +21,22 @@ namespace spec::upsample {
             }
            // std::cout << "amax: " << amax << " a, b, alpha: " << a << " " << b << " " << alpha << std::endl;
 
-            s = SigPolySpectrum(lut[amax].eval(a, b, alpha));
+            return lut[amax].eval(a, b, alpha);
         }
 
     }
 
+    void sigpoly_int(const Pixel &pixel, const SigpolyLUT lut[3], Float *dst)
+    {
+        const vec3 coef = upsample_to(pixel, lut);
+        dst[0] = coef.x;
+        dst[1] = coef.y;
+        dst[2] = coef.z;
+    }
+
     SigPolySpectrum sigpoly_int(const Pixel &pixel, const SigpolyLUT lut[3])
     {
-        SigPolySpectrum spectrum;
-        upsample_to(pixel, spectrum, lut);
-        return spectrum;
+        return SigPolySpectrum(upsample_to(pixel, lut));
     }
 
 }
\ No newline at end of file
@@ -1,4 +1,6 @@
 #include <upsample/functional/smits.h>
+#include <algorithm>
+#include <vector>
 
 namespace spec::upsample {
 
@@ -39,15 +41,14 @@ namespace spec::upsample {
             0.0000f, 0.0003f, 0.0369f, 0.0483f, 0.0496f
         }; 
 
-        void add_array_multiplied(BasicSpectrum &s, const Float mul, const Float *ptr)
+        void add_array_multiplied(Float *s, const Float mul, const Float *ptr)
         {
             for(unsigned i = 0; i < SMITS_SPECTRUM_SIZE; ++i) {
-                int wl = SMITS_WAVELENGHTS[i];
-                s.get_or_create(wl) += mul * (*(ptr++));
+                s[i] += mul * ptr[i];
             }
         }
 
-        void upsample_to(const vec3 &rgb, BasicSpectrum &s) 
+        void upsample_to(const vec3 &rgb, Float *s) 
         {
             if(rgb.x <= rgb.y && rgb.x <= rgb.z) {
                 add_array_multiplied(s, rgb[0], WHITE_SPECTRUM);
@@ -89,11 +90,17 @@ namespace spec::upsample {
 
     }
 
-    BasicSpectrum smits(const vec3 &rgb)
+    void smits(const vec3 &rgb, Float *dst)
     {
-        BasicSpectrum spectrum;
-        upsample_to(rgb, spectrum);
-        return spectrum;
+        std::fill(dst, dst + SMITS_SPECTRUM_SIZE, 0.0f);
+        upsample_to(rgb, dst);
+    }
+
+    SampledSpectrum smits(const vec3 &rgb)
+    {
+        std::vector<Float> values(SMITS_SPECTRUM_SIZE);
+        smits(rgb, values.data());
+        return SampledSpectrum(SMITS_WAVELENGHTS[0], SMITS_WAVELENGHTS[1] - SMITS_WAVELENGHTS[0], values);
     }
 
 }
\ No newline at end of file
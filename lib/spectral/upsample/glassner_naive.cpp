@@ -1,32 +1,62 @@
 #include <upsample/glassner_naive.h> 
 #include <upsample/functional/glassner.h>
-#include <internal/common/util.h>
+#include <spec/dense_spectral_image.h>
+#include <internal/common/progress.h>
 
 namespace spec {
 
 
     ISpectrum::ptr GlassnerUpsampler::upsample_pixel(const Pixel &pixel) const
     {
-        return ISpectrum::ptr(new BasicSpectrum(upsample::glassner(pixel.to_vec3())));
+        return ISpectrum::ptr(new SampledSpectrum(upsample::glassner(pixel.to_vec3())));
+    }
+
+    unsigned GlassnerUpsampler::get_batch_stride() const
+    {
+        return upsample::GLASSNER_SPECTRUM_SIZE;
+    }
+
+    void GlassnerUpsampler::upsample_batch(const Pixel *src, size_t count, Float *dst) const
+    {
+        for(size_t i = 0; i < count; ++i) {
+            upsample::glassner(src[i].to_vec3(), dst + i * upsample::GLASSNER_SPECTRUM_SIZE);
+        }
+    }
+
+    void GlassnerUpsampler::upsample_batch(const vec3 *src, size_t count, Float *dst) const
+    {
+        for(size_t i = 0; i < count; ++i) {
+            upsample::glassner(src[i], dst + i * upsample::GLASSNER_SPECTRUM_SIZE);
+        }
     }
 
     ISpectralImage::ptr GlassnerUpsampler::upsample(const Image &sourceImage) const
     {
-        BasicSpectralImage *dest = new BasicSpectralImage(sourceImage.get_width(), sourceImage.get_height());
-        const long img_size = sourceImage.get_width() * sourceImage.get_height();
-        init_progress_bar(img_size, 1000);
+        const std::vector<Float> wavelenghts(upsample::GLASSNER_WAVELENGHTS, upsample::GLASSNER_WAVELENGHTS + upsample::GLASSNER_SPECTRUM_SIZE);
+        DenseSpectralImage *dest = new DenseSpectralImage(sourceImage.get_width(), sourceImage.get_height(), wavelenghts);
+        const int width = sourceImage.get_width();
+        const int height = sourceImage.get_height();
+        Progress progress{size_t(width) * height};
 
-        for(unsigned i = 0; i < upsample::GLASSNER_SPECTRUM_SIZE; ++i) {
-            dest->add_wavelenght(upsample::GLASSNER_WAVELENGHTS[i]);
+        //GLASSNER_WAVELENGHTS are not sorted, so map them to bands of image
+        int bands[upsample::GLASSNER_SPECTRUM_SIZE];
+        for(unsigned k = 0; k < upsample::GLASSNER_SPECTRUM_SIZE; ++k) {
+            bands[k] = dest->find_band(upsample::GLASSNER_WAVELENGHTS[k]);
         }
 
         const Pixel *ptr = sourceImage.raw_data();
-        BasicSpectrum *s_ptr = dest->raw_data();
-        for(int i = 0; i < img_size; ++i) {
-            s_ptr[i] = upsample::glassner(ptr[i].to_vec3());
-            print_progress(i + 1);
+        #pragma omp parallel for
+        for(int j = 0; j < height; ++j) {
+            Float values[upsample::GLASSNER_SPECTRUM_SIZE];
+            for(long i = long(j) * width; i < long(j + 1) * width; ++i) {
+                upsample::glassner(ptr[i].to_vec3(), values);
+                for(unsigned k = 0; k < upsample::GLASSNER_SPECTRUM_SIZE; ++k) {
+                    dest->value(i, bands[k]) = values[k];
+                }
+            }
+            progress.add(width);
         }
-        finish_progress_bar();
+        progress.finish();
         return ISpectralImage::ptr(dest);
     }
 }
\ No newline at end of file
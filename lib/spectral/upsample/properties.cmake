@@ -5,7 +5,7 @@ set(MODULE_SOURCES
     glassner_naive.cpp
     smits.cpp
     sigpoly.cpp
-   #fourier.cpp
+    fourier.cpp
     functional/smits.cpp
     functional/glassner.cpp
     functional/sigpoly.cpp
@@ -1,46 +1,66 @@
 #include <upsample/sigpoly.h>
-#include <upsample/functional/sigpoly.h>
-#include <internal/common/util.h>
-#include <fstream>
+#include <internal/common/progress.h>
+#include <algorithm>
+#include <vector>
 
 namespace spec {
 
-    namespace {
+    SigPolyUpsampler::SigPolyUpsampler()
+        : lut_set{SigpolyLUT::load_from_file("resources/sp_lut0.slf"), SigpolyLUT::load_from_file("resources/sp_lut1.slf"), SigpolyLUT::load_from_file("resources/sp_lut2.slf")}
+    {
 
-        SigpolyLUT load_from_file(const std::string &path)
-        {
-            std::ifstream file{path};
-            return SigpolyLUT::load_from(file);
-        }
+    }
 
+    ISpectrum::ptr SigPolyUpsampler::upsample_pixel(const Pixel &src) const
+    {
+        return ISpectrum::ptr(new SigPolySpectrum(lut_set.eval(src)));
     }
 
-    SigPolyUpsampler::SigPolyUpsampler()
-        : luts{load_from_file("resources/sp_lut0.slf"), load_from_file("resources/sp_lut1.slf"), load_from_file("resources/sp_lut2.slf")}
+    unsigned SigPolyUpsampler::get_batch_stride() const
     {
+        return 3;
+    }
 
+    void SigPolyUpsampler::upsample_batch(const Pixel *src, size_t count, Float *dst) const
+    {
+        lut_set.eval_batch(src, count, dst);
     }
 
-    ISpectrum::ptr SigPolyUpsampler::upsample_pixel(const Pixel &src) const
+    void SigPolyUpsampler::upsample_batch(const vec3 *src, size_t count, Float *dst) const
     {
-        return ISpectrum::ptr(new SigPolySpectrum(upsample::sigpoly_int(src, luts)));
+        constexpr size_t CHUNK = 256;
+        Pixel pixels[CHUNK];
+        for(size_t start = 0; start < count; start += CHUNK) {
+            const size_t n = std::min(CHUNK, count - start);
+            for(size_t i = 0; i < n; ++i) {
+                pixels[i] = Pixel::from_vec3(src[start + i]);
+            }
+            lut_set.eval_batch(pixels, n, dst + start * 3);
+        }
     }
 
     ISpectralImage::ptr SigPolyUpsampler::upsample(const Image &sourceImage) const
     {
         SigPolySpectralImage *dest = new SigPolySpectralImage(sourceImage.get_width(), sourceImage.get_height());
        
-        const long img_size = sourceImage.get_width() * sourceImage.get_height();
-        init_progress_bar(img_size, 1000);
+        const int width = sourceImage.get_width();
+        const int height = sourceImage.get_height();
+        Progress progress{size_t(width) * height};
 
         const Pixel *ptr = sourceImage.raw_data();
         SigPolySpectrum *s_ptr = dest->raw_data();
-        for(int i = 0; i < img_size; ++i) {
-            s_ptr[i] = upsample::sigpoly_int(ptr[i], luts);
-            print_progress(i + 1);
+        #pragma omp parallel for
+        for(int j = 0; j < height; ++j) {
+            std::vector<Float> row(size_t(width) * 3);
+            const long offset = long(j) * width;
+            lut_set.eval_batch(ptr + offset, width, row.data());
+            for(int i = 0; i < width; ++i) {
+                s_ptr[offset + i] = SigPolySpectrum(vec3{row[i * 3], row[i * 3 + 1], row[i * 3 + 2]});
+            }
+            progress.add(width);
         }
 
-        finish_progress_bar();
+        progress.finish();
         return ISpectralImage::ptr(dest);
     }
 
@@ -1,33 +1,54 @@
 #include <upsample/smits.h>
 #include <upsample/functional/smits.h>
-#include <internal/common/util.h>
+#include <spec/dense_spectral_image.h>
+#include <internal/common/progress.h>
 
 namespace spec {
 
     ISpectrum::ptr SmitsUpsampler::upsample_pixel(const Pixel &src) const
     {
-        return ISpectrum::ptr(new BasicSpectrum(upsample::smits(src.to_vec3())));
+        return ISpectrum::ptr(new SampledSpectrum(upsample::smits(src.to_vec3())));
     }
 
-    ISpectralImage::ptr SmitsUpsampler::upsample(const Image &sourceImage) const
+    unsigned SmitsUpsampler::get_batch_stride() const
     {
-        BasicSpectralImage *dest = new BasicSpectralImage(sourceImage.get_width(), sourceImage.get_height());
-       
-        const long img_size = sourceImage.get_width() * sourceImage.get_height();
-        init_progress_bar(img_size, 1000);
+        return upsample::SMITS_SPECTRUM_SIZE;
+    }
 
-        for(unsigned i = 0; i < upsample::SMITS_SPECTRUM_SIZE; ++i) {
-            dest->add_wavelenght(upsample::SMITS_WAVELENGHTS[i]);
+    void SmitsUpsampler::upsample_batch(const Pixel *src, size_t count, Float *dst) const
+    {
+        for(size_t i = 0; i < count; ++i) {
+            upsample::smits(src[i].to_vec3(), dst + i * upsample::SMITS_SPECTRUM_SIZE);
         }
+    }
+
+    void SmitsUpsampler::upsample_batch(const vec3 *src, size_t count, Float *dst) const
+    {
+        for(size_t i = 0; i < count; ++i) {
+            upsample::smits(src[i], dst + i * upsample::SMITS_SPECTRUM_SIZE);
+        }
+    }
+
+    ISpectralImage::ptr SmitsUpsampler::upsample(const Image &sourceImage) const
+    {
+        const std::vector<Float> wavelenghts(upsample::SMITS_WAVELENGHTS, upsample::SMITS_WAVELENGHTS + upsample::SMITS_SPECTRUM_SIZE);
+        DenseSpectralImage *dest = new DenseSpectralImage(sourceImage.get_width(), sourceImage.get_height(), wavelenghts);
+       
+        const int width = sourceImage.get_width();
+        const int height = sourceImage.get_height();
+        Progress progress{size_t(width) * height};
 
+        //SMITS_WAVELENGHTS are sorted, so pixel values go to dense buffer as is
         const Pixel *ptr = sourceImage.raw_data();
-        BasicSpectrum *s_ptr = dest->raw_data();
-        for(int i = 0; i < img_size; ++i) {
-            s_ptr[i] = upsample::smits(ptr[i].to_vec3());
-            print_progress(i + 1);
+        Float *s_ptr = dest->raw_data();
+        #pragma omp parallel for
+        for(int j = 0; j < height; ++j) {
+            const long row = long(j) * width;
+            upsample_batch(ptr + row, width, s_ptr + row * upsample::SMITS_SPECTRUM_SIZE);
+            progress.add(width);
         }
 
-        finish_progress_bar();
+        progress.finish();
         return ISpectralImage::ptr(dest);
     }
 }
\ No newline at end of file
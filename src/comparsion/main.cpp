@@ -1,5 +1,5 @@
 #include <spec/spectral_util.h>
-#include <spec/basic_spectrum.h>
+#include <spec/sampled_spectrum.h>
 #include <spec/conversions.h>
 #include <spec/metrics.h>
 #include <internal/serialization/csv.h>
@@ -44,7 +44,22 @@ std::unique_ptr<IUpsampler> get_upsampler_by_name(const std::string &method_name
     return std::unique_ptr<IUpsampler>(ptr);
 }
 
-void load_spec_ds(const std::string &path, std::vector<Float> &wavelenghts, std::vector<BasicSpectrum> &spectra) {
+/**
+ *  Writes one line of comma separated values at all wavelenghts for each spectrum.
+ */
+void write_spectra_values(std::ostream &file, const std::vector<SampledSpectrum> &spectra)
+{
+    std::vector<Float> values((WAVELENGHTS_END - WAVELENGHTS_START) / WAVELENGHTS_STEP + 1);
+    for(const SampledSpectrum &sp : spectra) {
+        sp.sample_into(WAVELENGHTS_START, WAVELENGHTS_STEP, values.size(), values.data());
+        for(size_t i = 0; i + 1 < values.size(); ++i) {
+            file << values[i] << ",";
+        }
+        file << values.back() << std::endl;
+    }
+}
+
+void load_spec_ds(const std::string &path, std::vector<Float> &wavelenghts, std::vector<SampledSpectrum> &spectra) {
     std::ifstream file_in{path};
 
     auto header = *csv::parse_line_m<spec::Float, csv::skip>(file_in);
@@ -54,12 +69,7 @@ void load_spec_ds(const std::string &path, std::vector<Float> &wavelenghts, std:
 
     wavelenghts = std::get<0>(header);
     for(const auto &entry : table) {
-        BasicSpectrum spectrum;
-        const std::vector<spec::Float> &values = std::get<0>(entry);
-        for(unsigned i = 0; i < wavelenghts.size(); ++i) {
-            spectrum.set(wavelenghts[i], values[i]);
-        }
-        spectra.push_back(spectrum);
+        spectra.emplace_back(wavelenghts, std::get<0>(entry));
     }
 }
 
@@ -84,10 +94,10 @@ Float stddev(const std::vector<Float> &vals, Float mean) {
 
 void dataset_reupsample(const IUpsampler &upsampler, const std::string &method_name)
 {
-    std::vector<BasicSpectrum> in_spectra;
+    std::vector<SampledSpectrum> in_spectra;
     std::vector<Float> wavelenghts;
     load_spec_ds("input/munsell380_800_1.csv", wavelenghts, in_spectra);
-    std::vector<BasicSpectrum> out_spectra(in_spectra.size());
+    std::vector<SampledSpectrum> out_spectra(in_spectra.size());
 
     std::ofstream output_file("output/comparsion_ds_result_" + method_name + ".csv");
     std::ofstream result_spectra_file("output/comparsion_ds_converted_" + method_name + ".csv");
@@ -148,19 +158,8 @@ void dataset_reupsample(const IUpsampler &upsampler, const std::string &method_n
     result_spectra_file << WAVELENGHTS_END << std::endl;
     ds_spectra_file << WAVELENGHTS_END << std::endl;
 
-    for(const BasicSpectrum &sp : in_spectra) {
-        for(int i = WAVELENGHTS_START; i < WAVELENGHTS_END; i += WAVELENGHTS_STEP) {
-            ds_spectra_file << sp(i) << ",";
-        }
-        ds_spectra_file << sp(WAVELENGHTS_END) << std::endl;
-    }
-
-    for(const BasicSpectrum &sp : out_spectra) {
-        for(int i = WAVELENGHTS_START; i < WAVELENGHTS_END; i += WAVELENGHTS_STEP) {
-            result_spectra_file << sp(i) << ",";
-        }
-        result_spectra_file << sp(WAVELENGHTS_END) << std::endl;
-    }
+    write_spectra_values(ds_spectra_file, in_spectra);
+    write_spectra_values(result_spectra_file, out_spectra);
 }
 
     
@@ -241,7 +240,7 @@ void img_simpletest(const IUpsampler &upsampler, const std::string &path, const
     image.save("output/comparsion/textures/" + name + "_" + method + ".png");
 }
 
-vec3 ior2rgb(const BasicSpectrum &spec_eta, const BasicSpectrum &spec_k)
+vec3 ior2rgb(const ISpectrum &spec_eta, const ISpectrum &spec_k)
 {
     Float cieyint = util::get_cie_y_integral();
     vec3 xyz{0.0f, 0.0f, 0.0f};
@@ -265,8 +264,8 @@ vec3 ior2rgb(const BasicSpectrum &spec_eta, const BasicSpectrum &spec_k)
 
 void ior_reupsample(const IUpsampler &upsampler, const std::string &path_eta, const std::string &path_k, const std::string &method)
 {
-    const BasicSpectrum spec_eta_gt = util::load_spd(path_eta);
-    const BasicSpectrum spec_k_gt = util::load_spd(path_k);
+    const SampledSpectrum spec_eta_gt = util::load_spd(path_eta);
+    const SampledSpectrum spec_k_gt = util::load_spd(path_k);
 
     const vec3 rgb_gt = ior2rgb(spec_eta_gt, spec_k_gt);
 
@@ -274,8 +273,8 @@ void ior_reupsample(const IUpsampler &upsampler, const std::string &path_eta, co
 
     ISpectrum::ptr spectrum = upsampler.upsample_pixel(Pixel::from_vec3(rgb_gt));
 
-    BasicSpectrum spec_eta;
-    BasicSpectrum spec_k;
+    SampledSpectrum spec_eta;
+    SampledSpectrum spec_k;
 
     for(int wl = WAVELENGHTS_START; wl <= WAVELENGHTS_END; wl += WAVELENGHTS_STEP) {
         auto [eta, k] = color2ior(spectrum->get_or_interpolate(wl));
@@ -300,12 +299,12 @@ const vec3 COLOR_POWER{27.4722f, 71.8074f, 7.63813f};
 
 void emiss_reupsample()
 {
-    std::vector<BasicSpectrum> in_spectra;
+    std::vector<SampledSpectrum> in_spectra;
     std::vector<Float> wavelenghts;
     std::vector<vec3> in_rgbs;
     load_spec_ds("output/dataset_spectra_val.csv", wavelenghts, in_spectra);
     load_vec_ds("output/dataset_rgb_val.csv", in_rgbs);
-    std::vector<BasicSpectrum> out_spectra(in_spectra.size());
+    std::vector<SampledSpectrum> out_spectra(in_spectra.size());
 
     std::ofstream output_file("output/comparsion/comparsion_em_result.csv");
     std::ofstream result_spectra_file("output/comparsion/comparsion_em_converted.csv");
@@ -317,9 +316,7 @@ void emiss_reupsample()
     std::vector<Float> spec_sams(in_spectra.size());
 
 
-    std::ifstream lut_file{"resources/f_emission_lut.eflf"};
-    FourierLUT lut = FourierLUT::load_from(lut_file);
-    lut_file.close();
+    FourierLUT lut = FourierLUT::load_from_file("resources/f_emission_lut.eflf");
 
     for(unsigned i = 0; i < in_spectra.size(); ++i) {
         vec3 rgb = in_rgbs[i];
@@ -374,23 +371,34 @@ void emiss_reupsample()
     result_spectra_file << WAVELENGHTS_END << std::endl;
     ds_spectra_file << WAVELENGHTS_END << std::endl;
 
-    for(const BasicSpectrum &sp : in_spectra) {
-        for(int i = WAVELENGHTS_START; i < WAVELENGHTS_END; i += WAVELENGHTS_STEP) {
-            ds_spectra_file << sp(i) << ",";
-        }
-        ds_spectra_file << sp(WAVELENGHTS_END) << std::endl;
-    }
+    write_spectra_values(ds_spectra_file, in_spectra);
+    write_spectra_values(result_spectra_file, out_spectra);
+}
 
-    for(const BasicSpectrum &sp : out_spectra) {
-        for(int i = WAVELENGHTS_START; i < WAVELENGHTS_END; i += WAVELENGHTS_STEP) {
-            result_spectra_file << sp(i) << ",";
-        }
-        result_spectra_file << sp(WAVELENGHTS_END) << std::endl;
+/**
+ *  Removes '--threads n' from arguments and sets number of threads.
+ */
+bool parse_threads(int &argc, char **argv)
+{
+    for(int i = 1; i < argc; ++i) {
+        if(strcmp(argv[i], "--threads")) continue;
+        if(i + 1 >= argc) return false;
+
+        const int threads = std::atoi(argv[i + 1]);
+        if(threads < 1) return false;
+#ifdef SPECTRAL_ENABLE_OPENMP
+        omp_set_num_threads(threads);
+#endif
+        std::copy(argv + i + 2, argv + argc, argv + i);
+        argc -= 2;
+        return true;
     }
+    return true;
 }
 
 int main(int argc, char **argv)
 {
+    if(!parse_threads(argc, argv)) return 1;
     if(argc < 2) return 1;
     const std::string method = argv[1];
     if(method == "fourier") {
@@ -32,6 +32,9 @@ bool parse_args(int argc, char **argv, Args &args)
     static struct option long_options[] = {
         {"downsample", no_argument, nullptr, 1},
         {"ior", no_argument, nullptr, 2},
+        {"threads", required_argument, nullptr, 3},
+        {"format", required_argument, nullptr, 4},
+        {"verify-luts", no_argument, nullptr, 5},
         {nullptr, 0, nullptr, 0}
     };
 
@@ -45,6 +48,19 @@ bool parse_args(int argc, char **argv, Args &args)
         case 2:
             args.ior_mode = true;
             break;
+        case 3:
+            args.threads = std::stoi(optarg);
+            if(args.threads < 1) {
+                std::cerr << "[!] Number of threads must be positive." << std::endl;
+                return false;
+            }
+            break;
+        case 4:
+            args.format = optarg;
+            break;
+        case 5:
+            args.verify_luts = true;
+            break;
         case 'c':
             if(input_type != InputType::NONE) return false;
             args.color = Pixel::from_rgb(std::stoi(optarg, nullptr, 16));
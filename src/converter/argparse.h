@@ -14,6 +14,9 @@ struct Args {
     std::string input_path; // -f
     bool downsample_mode = false; // --downsample
     bool ior_mode = false; //--ior
+    int threads = 0; //--threads, 0 means default
+    bool verify_luts = false; //--verify-luts
+    std::string format; //--format, empty means default format of the method
 };
 
 bool parse_args(int argc, char **argv, Args &args);
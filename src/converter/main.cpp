@@ -8,12 +8,16 @@
 #include <spec/conversions.h>
 #include <internal/common/format.h>
 #include <internal/common/util.h>
+#include <internal/serialization/lut_file.h>
 #include <chrono>
 #include <stdexcept>
 #include <filesystem>
 #include <iostream>
 #include <fstream>
 #include <memory>
+#ifdef SPECTRAL_ENABLE_OPENMP
+#include <omp.h>
+#endif
 
 using std::chrono::high_resolution_clock;
 using std::chrono::duration_cast;
@@ -56,27 +60,14 @@ int downsample(const Args &args) {
             return 2;
         }        
         std::cout << "Converting spectum to RGB..." << std::endl;
-        vec3 downsampled_rgb = xyz2rgb(spectre2xyz(*spec, *illum));
+        vec3 downsampled_rgb = spectre2rgb(*spec, *spec::util::compute_cmf_weights(*illum));
         std::ofstream output{output_path + ".txt"};
         output << downsampled_rgb.x << " " << downsampled_rgb.y << " " << downsampled_rgb.z << std::endl; 
         return 0;
     }
 
-    const int w = spec_img->get_width();
-    const int h = spec_img->get_height();
-    Image img{w, h};
-
-
     std::cout << "Converting spectral image to png..." << std::endl;
-    init_progress_bar(w * h, 1000);
-
-    for(int j = 0; j < h; ++j) {
-        for(int i = 0; i < w; ++i) {
-            img.at(i, j) = Pixel::from_vec3(xyz2rgb(spectre2xyz(spec_img->at(i, j), *illum)));
-            print_progress(j * w + i);
-        }
-    }
-    finish_progress_bar();
+    Image img = spectral_image2rgb(*spec_img, *spec::util::compute_cmf_weights(*illum));
 
     img.save(output_path + ".png");
 
@@ -140,7 +131,7 @@ int upsample(const Args &args) {
 
         std::cout << "Saving..." << std::endl;
 
-        if(!spec::util::save(args.output_dir, *args.output_name, *spectral_img)) {
+        if(!spec::util::save(args.output_dir, *args.output_name, *spectral_img, args.format)) {
             std::cerr << "[!] Error saving image." << std::endl;
             return 3;
         }
@@ -156,11 +147,24 @@ int upsample(const Args &args) {
  *  -c (hex):    use color code instead of texture
  *  -f (path):   path to texture
  *  -m (method): method to use
+ *  --threads (n): number of threads to use
+ *  --format (f): output format of spectral image (png1, envi, envi_bil, envi_bip, with '_be' suffix for big-endian ENVI)
+ *  --verify-luts: verify checksums of LUT files on load
  */
 int main(int argc, char **argv)
 {
     Args args;
     if(!parse_args(argc, argv, args)) return 1;
 
+    if(args.threads > 0) {
+#ifdef SPECTRAL_ENABLE_OPENMP
+        omp_set_num_threads(args.threads);
+#else
+        std::cerr << "[!] Built without OpenMP, --threads is ignored." << std::endl;
+#endif
+    }
+
+    if(args.verify_luts) spec::lut_file::set_checksum_verification(true);
+
     return args.downsample_mode ? downsample(args) : upsample(args);
 } 
@@ -273,7 +273,7 @@ int main(int argc, char **argv)
     for(int i = WAVELENGHTS_START; i <= WAVELENGHTS_END; ++i) {
         wavelenghts.push_back(Float(i));
     }
-    BasicSpectrum spec = upsample::smits({1.0f, 1.0f, 1.0f});
+    SampledSpectrum spec = upsample::smits({1.0f, 1.0f, 1.0f});
     std::vector<Float> val(wavelenghts.size());
     for(unsigned i = 0; i < wavelenghts.size(); ++i) val[i] = spec(wavelenghts[i]);
 
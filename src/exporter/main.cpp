@@ -9,12 +9,12 @@
 #include <fstream>
 #include <cstring>
 #include <iostream>
+#include <vector>
 
 using namespace spec;
 
 FourierLUT load_lut(const std::string &path) {
-    std::ifstream file{path};
-    return FourierLUT::load_from(file);
+    return FourierLUT::load_from_file(path);
 }
 
 int main(int argc, char **argv)
@@ -32,10 +32,15 @@ int main(int argc, char **argv)
 
     FourierEmissionSpectrum fspec = upsample::fourier_emiss_int(color, 25.0f, lut);
 
+    const math::PhaseGrid &grid = math::cie_phase_grid();
+    std::vector<Float> values(grid.size());
+    fspec.sample(grid, values.data());
+
     BasicSpectrum spec;
-    for(int wl = WAVELENGHTS_START; wl <= WAVELENGHTS_END; wl += WAVELENGHTS_STEP)
+    unsigned idx = 0;
+    for(int wl = WAVELENGHTS_START; wl <= WAVELENGHTS_END; wl += WAVELENGHTS_STEP, ++idx)
     {
-        spec.set(wl, fspec.get_or_interpolate(wl));
+        spec.set(wl, values[idx]);
     }
 
     util::save_spd(format("output/spd/%s.spd", argv[1]), spec);
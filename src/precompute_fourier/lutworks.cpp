@@ -1,6 +1,5 @@
 #include "lutworks.h"
-#include <internal/serialization/binary.h>
-#include <internal/common/util.h>
+#include <internal/common/progress.h>
 #include <spec/conversions.h>
 #include <vector>
 #include <limits>
@@ -10,32 +9,9 @@
 #include <cassert>
 #include <iostream>
 
-namespace bin = spec::binary;
-
-void write_header(std::ostream &dst)
-{
-    bin::write<uint64_t>(dst, spec::FourierLUT::FILE_MARKER);
-    bin::write<uint16_t>(dst, sizeof(Float));
-}
-
 void write_lut(std::ostream &dst, const FourierLUT &lut)
-{  
-    unsigned step = lut.get_step();
-    bin::write<uint16_t>(dst, step);
-    bin::write<uint16_t>(dst, lut.get_m());
-
-    const auto &pvals = lut.get_power_vals();
-    bin::write<uint16_t>(dst, pvals.size());
-    for(unsigned i = 0; i < pvals.size(); ++i) {
-        bin::write<Float>(dst, pvals[i]);
-    }
-
-    unsigned count = lut.get_size();
-    count = pvals.size() * count * count * count * (lut.get_m() + 1);
-    const Float *ptr = lut.get_raw_data();
-    for(unsigned i = 0; i < count ; ++i) {
-        bin::write<Float>(dst, ptr[i]);
-    }
+{
+    lut.save_to(dst);
 }
 constexpr int DEFAULT_P_ID = 0;
 
@@ -212,9 +188,7 @@ namespace {
         }
     }
 
-    unsigned color_processed = 0;
-
-    void fill_layer(LutBuilder &ctx, unsigned knearest)
+    void fill_layer(LutBuilder &ctx, unsigned knearest, spec::Progress &progress)
     {
         std::vector<double> solution(ctx.m + 1);
         std::vector<Float> values(ctx.dataset_wavelenghts.size());
@@ -234,26 +208,21 @@ namespace {
 
                         solve_for_rgb(ctx.get_target().cast<Float>() / 255.0f, ctx.target_power(), solution, ctx.dataset_wavelenghts, values);
                         std::copy(solution.begin(), solution.end(), ctx.current());
-                        color_processed += 1;
-                    }
-                    else {
-
+                        progress.add();
                     }
-
-                    spec::print_progress(color_processed);
                 }
             }
 
         }
     }
 
-    void fill(LutBuilder &ctx, unsigned knearest)
+    void fill(LutBuilder &ctx, unsigned knearest, spec::Progress &progress)
     {
         for(ctx.n = DEFAULT_P_ID; ctx.n < ctx.p_size; ++ctx.n) {
-            fill_layer(ctx, knearest);
+            fill_layer(ctx, knearest, progress);
         }
         for(ctx.n = DEFAULT_P_ID - 1; ctx.n >= 0; --ctx.n) {
-            fill_layer(ctx, knearest);
+            fill_layer(ctx, knearest, progress);
         }
     }
 
@@ -267,8 +236,7 @@ namespace {
 
     void prepare_seeds(const std::vector<Float> &in_wavelenghts, const std::vector<std::vector<Float>> &in_seeds, const std::vector<vec3i> &rgbs, Float power, std::unordered_map<vec3i, std::vector<Float>> &out_seeds, int step)
     {   
-        init_progress_bar(in_seeds.size());
-        color_processed = 0u;
+        spec::Progress progress{in_seeds.size()};
 
         auto phases = math::wl_to_phases(in_wavelenghts);
 
@@ -314,9 +282,9 @@ namespace {
                 std::vector<Float> res = math::real_fourier_moments_of(phases, spec_values, M + 1);
                 out_seeds.emplace(rgb, std::vector<Float>(res.begin(), res.end()));
             }
-            print_progress(++color_processed);
+            progress.add();
         }
-        finish_progress_bar();
+        progress.finish();
     }
 
 }
@@ -366,13 +334,11 @@ FourierLUT generate_lut(const std::vector<Float> &wavelenghts, const std::vector
     }
 
     std::cout << std::endl;
-    color_processed = 0u;
-
     LutBuilder ctx{M, step, wavelenghts, seeds, seeds_converted};
-    init_progress_bar(ctx.p_size * ctx.size * ctx.size * ctx.size - seeds.size(), 100);
+    spec::Progress progress{size_t(ctx.p_size) * ctx.size * ctx.size * ctx.size - seeds.size()};
 
-    fill(ctx, knearest);
+    fill(ctx, knearest, progress);
 
-    finish_progress_bar();
+    progress.finish();
     return ctx.build_and_clear();
 }
\ No newline at end of file
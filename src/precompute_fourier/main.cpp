@@ -57,10 +57,9 @@ int main(int argc, char **argv)
 
     FourierLUT lut = generate_lut(ds_wavelenghts, ds_spectra, ds_rgbs, param_step, param_knearest);
 
-    std::ofstream output{EMISS_LUT_FILENAME};
+    std::ofstream output{EMISS_LUT_FILENAME, std::ios::binary};
 
     std::cout << "Writing data to " << EMISS_LUT_FILENAME << "." << std::endl;
-    write_header(output);
     write_lut(output, lut);
     std::cout << "Successfully written data." << std::endl;
 
@@ -1,16 +1,13 @@
 #ifndef ARGPARSE_H
 #define ARGPARSE_H
-#include <imageutil/pixel.h>
-#include <string>
 #include <optional>
 
 struct Args {
-    bool refresh = false;
-    std::optional<spec::Pixel> color_in;
-    std::string output_path = "output/sigpolylut.spl";
+    std::optional<int> zeroed_idx; //only LUT for this channel is generated, all three otherwise
+    int threads = 0; //--threads, 0 means default
 };
 
 bool parse_args(int argc, char **argv, Args &args);
 
 
-#endif
\ No newline at end of file
+#endif
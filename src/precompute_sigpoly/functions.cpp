@@ -1,60 +1,24 @@
 #include "functions.h"
 #include <spec/conversions.h>
-#include <ceres/ceres.h>
-
-using namespace ceres;
+#include <upsample/functional/sigpoly_fit.h>
+#include <iostream>
 
 bool enable_logging = false;
 
-struct CostFunctor {
-    const vec3 in;
-
-    CostFunctor(const vec3 &rgb)
-        : in(spec::rgb2cielab(rgb)) {}
+namespace {
 
-    template<typename T>
-    bool operator()(const T *const x, T *residual) const
+    const spec::upsample::SigpolyFit &get_fit()
     {
-        base_vec3<T> result = _xyz2cielab<T>(_sigpoly2xyz<T>(x));
-
-        result -= in.cast<T>();
-
-        residual[0] = result.x;
-        residual[1] = result.y;
-        residual[2] = result.z;
-
-        return true;
+        static const spec::upsample::SigpolyFit fit{};
+        return fit;
     }
-};
+
+}
 
 vec3d solve_for_rgb(const vec3 &rgb, const vec3d &init)
 {
     vec3d x = init;
-
-    if(enable_logging) {
-        std::cout << "Solving for color: " << rgb << std::endl;
-    }
-
-    // Build the problem.
-    Problem problem;
-
-    // Set up the only cost function (also known as residual). This uses
-    // auto-differentiation to obtain the derivative (jacobian).
-    CostFunction* cost_function =
-      new AutoDiffCostFunction<CostFunctor, 3, 3>(new CostFunctor(rgb));
-    problem.AddResidualBlock(cost_function, nullptr, x.v);
-
-    // Run the solver!
-    Solver::Options options;
-    options.max_num_iterations = 100;
-    options.linear_solver_type = ceres::DENSE_QR;
-    options.minimizer_progress_to_stdout = enable_logging;
-    Solver::Summary summary;
-    Solve(options, &problem, &summary);
-
-    if(enable_logging) {
-        std::cout << summary.BriefReport() << "\n";
-    }
+    solve_for_rgb_d(rgb, x);
     return x;
 }
 
@@ -64,26 +28,11 @@ void solve_for_rgb_d(const vec3 &rgb, vec3d &x)
         std::cout << "Solving for color: " << rgb << std::endl;
     }
 
-    // Build the problem.
-    Problem problem;
-
-    // Set up the only cost function (also known as residual). This uses
-    // auto-differentiation to obtain the derivative (jacobian).
-    CostFunction* cost_function =
-      new AutoDiffCostFunction<CostFunctor, 3, 3>(new CostFunctor(rgb));
-    problem.AddResidualBlock(cost_function, nullptr, x.v);
-
-    // Run the solver!
-    Solver::Options options;
-    options.num_threads = 4;
-    options.max_num_iterations = 100;
-    options.linear_solver_type = ceres::DENSE_QR;
-    options.minimizer_progress_to_stdout = enable_logging;
-    Solver::Summary summary;
-    Solve(options, &problem, &summary);
+    const spec::upsample::SigpolyFit::Summary summary = get_fit().solve(rgb, x);
 
     if(enable_logging) {
-        std::cout << summary.BriefReport() << "\n";
+        std::cout << "Iterations: " << summary.iterations << ", initial cost: " << summary.initial_cost
+                  << ", final cost: " << summary.final_cost << (summary.converged ? "" : " (not converged)") << std::endl;
     }
 }
 
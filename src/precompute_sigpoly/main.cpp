@@ -1,37 +1,51 @@
+#include "argparse.h"
 #include "functions.h"
 #include "lutworks.h"
-#include <internal/serialization/parsers.h>
 #include <internal/common/format.h>
 #include <iostream>
 #include <fstream>
-#include <glog/logging.h>
+#ifdef SPECTRAL_ENABLE_OPENMP
+#include <omp.h>
+#endif
 
-int main(int argc, char **argv)
-{   
-    google::InitGoogleLogging(argv[0]);
-
-    if(argc == 2) {
-        int zeroed_idx = spec::parse<int>(argv[1]);
+namespace {
 
+    void generate_and_write(int zeroed_idx)
+    {
         SigpolyLUT lut = generate_lut(zeroed_idx, 4, 24);
         std::string output_path = spec::format("output/sp_lut%d.slf", zeroed_idx);
-        std::ofstream output{output_path};
+        std::ofstream output{output_path, std::ios::binary};
 
         std::cout << "Writing data to " << output_path << "." << std::endl;
-        write_header(output);
         write_lut(output, lut);
         std::cout << "Successfully written data." << std::endl;
     }
+
+}
+
+/**
+ *  (idx):         generate only LUT with maximal channel idx (0, 1 or 2), all three otherwise
+ *  --threads (n): number of threads to use
+ */
+int main(int argc, char **argv)
+{   
+    Args args;
+    if(!parse_args(argc, argv, args)) return 1;
+
+    if(args.threads > 0) {
+#ifdef SPECTRAL_ENABLE_OPENMP
+        omp_set_num_threads(args.threads);
+#else
+        std::cerr << "[!] Built without OpenMP, --threads is ignored." << std::endl;
+#endif
+    }
+
+    if(args.zeroed_idx) {
+        generate_and_write(*args.zeroed_idx);
+    }
     else {
         for(int i = 0; i < 3; ++i) {
-            SigpolyLUT lut = generate_lut(i, 4, 24);
-            std::string output_path = spec::format("output/sp_lut%d.slf", i);
-            std::ofstream output{output_path};
-
-            std::cout << "Writing data to " << output_path << "." << std::endl;
-            write_header(output);
-            write_lut(output, lut);
-            std::cout << "Successfully written data." << std::endl;
+            generate_and_write(i);
         }
     }
 
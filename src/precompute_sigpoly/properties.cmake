@@ -2,10 +2,11 @@ set(MODULE_NAME precompute_sigpoly)
 
 set(MODULE_SOURCES
     main.cpp
+    argparse.cpp
     functions.cpp
     lutworks.cpp
 )
 
 set(MODULE_LIBS
-    spectral ceres
+    spectral
 )
\ No newline at end of file